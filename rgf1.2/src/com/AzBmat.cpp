@@ -0,0 +1,198 @@
+/* * * * *
+ *  AzBmat.cpp 
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#include "AzBmat.hpp"
+
+/*--------------------------------------------------------*/
+int *AzBmatStore::append(const int *ints, int num, 
+                         int *out_chunk, int *out_offs) /* output */
+{
+  const char *eyec = "AzBmatStore::append"; 
+  if (chunk_num <= 0 || 
+      (chunks[chunk_num-1]->size() > 0 && 
+       (AzInt64)chunks[chunk_num-1]->size() + num > chunk_max)) {
+    if (chunk_num >= a_chunks.size()) {
+      int new_num = MAX(16, chunk_num*2); 
+      if (chunks == NULL) a_chunks.alloc(&chunks, new_num, eyec, "chunks"); 
+      else                a_chunks.realloc(&chunks, new_num, eyec, "chunks"); 
+    }
+    chunks[chunk_num++] = new AzIntArr(); 
+  }
+  AzIntArr *ia = chunks[chunk_num-1]; 
+  *out_chunk = chunk_num-1; 
+  *out_offs = ia->size(); 
+  if (ints != NULL) {
+    ia->concat(ints, num); 
+  }
+  else {
+    int ix; 
+    for (ix = 0; ix < num; ++ix) ia->put(0); 
+  }
+  total += num; 
+  return ia->point_u() + *out_offs; 
+}
+
+/*--------------------------------------------------------*/
+AzInt64 AzBmatStore::memSize() const
+{
+  AzInt64 sz = (AzInt64)a_chunks.size()*sizeof(AzIntArr *); 
+  int cx; 
+  for (cx = 0; cx < chunk_num; ++cx) sz += chunks[cx]->memSize(); 
+  return sz; 
+}
+
+/*--------------------------------------------------------*/
+void AzBmatStore::transfer_from(AzBmatStore *inp)
+{
+  a_chunks.transfer_from(&inp->a_chunks, &chunks, &inp->chunks, 
+                         "AzBmatStore::transfer_from"); 
+  chunk_num = inp->chunk_num; inp->chunk_num = 0; 
+  total = inp->total; inp->total = 0; 
+}
+
+/*--------------------------------------------------------*/
+void AzBmat::set(const AzBmat *inp)
+{
+  if (inp == this) return; 
+  reset(); 
+  row_num = inp->row_num; 
+  resize(inp->col_num); 
+  int col; 
+  for (col = 0; col < col_num; ++col) {
+    const AzBmatCol *inp_cp = &inp->cols[col]; 
+    AzBmatCol *cp = &cols[col]; 
+    cp->num = inp_cp->num; 
+    cp->isBits = inp_cp->isBits; 
+    if (cp->num <= 0) continue; 
+    if (cp->isBits) {
+      ia_bits.append(inp->ia_bits.point(inp_cp->chunk, inp_cp->offs), 
+                     inp->wordNum(), &cp->chunk, &cp->offs); 
+    }
+    else {
+      ia_rows.append(inp->ia_rows.point(inp_cp->chunk, inp_cp->offs), 
+                     inp_cp->num, &cp->chunk, &cp->offs); 
+    }
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzBmat::resize(int new_col_num)
+{
+  const char *eyec = "AzBmat::resize"; 
+  if (new_col_num < col_num) {
+    throw new AzException(eyec, "#col can only grow"); 
+  }
+  if (new_col_num == col_num) return; 
+  if (cols == NULL) a_cols.alloc(&cols, new_col_num, eyec, "cols"); 
+  else              a_cols.realloc(&cols, new_col_num, eyec, "cols"); 
+  int col; 
+  for (col = col_num; col < new_col_num; ++col) {
+    cols[col].chunk = cols[col].offs = cols[col].num = cols[col].isBits = 0; 
+  }
+  col_num = new_col_num; 
+}
+
+/*--------------------------------------------------------*/
+void AzBmat::on_rows(int col, AzIntArr *ia_on_rows) const
+{
+  checkCol(col, "AzBmat::on_rows"); 
+  ia_on_rows->reset(); 
+  const AzBmatCol *cp = &cols[col]; 
+  if (cp->num <= 0) return; 
+  if (!cp->isBits) {
+    ia_on_rows->reset(ia_rows.point(cp->chunk, cp->offs), cp->num); 
+    return; 
+  }
+  ia_on_rows->prepare(cp->num); 
+  const int *bits = ia_bits.point(cp->chunk, cp->offs); 
+  int wx, w_num = wordNum(); 
+  for (wx = 0; wx < w_num; ++wx) {
+    unsigned int word = (unsigned int)bits[wx]; 
+    int row = wx*32; 
+    for ( ; word != 0; word >>= 1, ++row) {
+      if (word & 1) ia_on_rows->put(row); 
+    }
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzBmat::clear(int col)
+{
+  checkCol(col, "AzBmat::clear"); 
+  AzBmatCol *cp = &cols[col]; 
+  if (cp->num > 0) {
+    hole_num += (cp->isBits) ? wordNum() : cp->num; 
+  }
+  cp->chunk = cp->offs = cp->num = cp->isBits = 0; 
+  if (hole_num > 1024 && hole_num > (ia_rows.size()+ia_bits.size())/2) {
+    squeeze(); 
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzBmat::load(int col, const AzIntArr *ia_on_rows)
+{
+  if (ia_on_rows == NULL || ia_on_rows->size() <= 0) return; 
+
+  if (ia_on_rows->min() < 0 || 
+      ia_on_rows->max() >= row_num) {
+    throw new AzException("AzBmat::load", "wrong row#"); 
+  }
+  clear(col); 
+  AzBmatCol *cp = &cols[col]; 
+  int num; 
+  const int *rows = ia_on_rows->point(&num); 
+  cp->num = num; 
+  if (num > wordNum()) {
+    cp->isBits = 1; 
+    int *bits = ia_bits.append(NULL, wordNum(), &cp->chunk, &cp->offs); 
+    int ix; 
+    for (ix = 0; ix < num; ++ix) {
+      int row = rows[ix]; 
+      bits[row/32] |= (int)(1u << (row%32)); 
+    }
+  }
+  else {
+    cp->isBits = 0; 
+    ia_rows.append(rows, num, &cp->chunk, &cp->offs); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* Copy the live columns into fresh arrays in column order */
+void AzBmat::squeeze()
+{
+  AzBmatStore new_rows, new_bits; 
+  int w_num = wordNum(); 
+  int col; 
+  for (col = 0; col < col_num; ++col) {
+    AzBmatCol *cp = &cols[col]; 
+    if (cp->num <= 0) continue; 
+    if (cp->isBits) {
+      new_bits.append(ia_bits.point(cp->chunk, cp->offs), w_num, 
+                      &cp->chunk, &cp->offs); 
+    }
+    else {
+      new_rows.append(ia_rows.point(cp->chunk, cp->offs), cp->num, 
+                      &cp->chunk, &cp->offs); 
+    }
+  }
+  ia_rows.transfer_from(&new_rows); 
+  ia_bits.transfer_from(&new_bits); 
+  hole_num = 0; 
+}
@@ -20,25 +20,84 @@
 #define _AZ_BMAT_HPP_
 #include "AzUtil.hpp"
 
+/*---  where the on-rows of a column are  ---*/
+typedef struct {
+  int chunk; /* of ia_rows, or of ia_bits if isBits */
+  int offs;  /* in the chunk */
+  int num;   /* #on-rows */
+  int isBits; 
+} AzBmatCol; 
+AzDeclarePod(AzBmatCol)
+
+//! ints appended in chunks so that the total isn't limited by int 
+/*-------------------------------------------------------------------*/
+/* A chunk takes up to chunk_max ints; a single append larger than  */
+/* that gets a chunk of its own.                                     */
+/*-------------------------------------------------------------------*/
+class AzBmatStore {
+protected:
+  AzIntArr **chunks; 
+  AzObjPtrArray<AzIntArr> a_chunks; 
+  int chunk_num; 
+  AzInt64 total; 
+  static const int chunk_max = 256*1024*1024; 
+
+public:
+  AzBmatStore() : chunks(NULL), chunk_num(0), total(0) {}
+  inline void reset() {
+    a_chunks.free(&chunks); 
+    chunk_num = 0; 
+    total = 0; 
+  }
+  /*---  append num ints, or num zeros if ints is NULL  ---*/
+  int *append(const int *ints, int num, 
+              int *out_chunk, int *out_offs); /* output */
+  inline const int *point(int chunk, int offs) const {
+    return chunks[chunk]->point() + offs; 
+  }
+  inline AzInt64 size() const { return total; }
+  AzInt64 memSize() const; 
+  void transfer_from(AzBmatStore *inp); 
+
+  /*---  prohibit copying  ---*/
+  AzBmatStore(const AzBmatStore &) {
+    throw new AzException("AzBmatStore(const &)", "no support"); 
+  }
+  AzBmatStore & operator =(const AzBmatStore &inp) {
+    if (this == &inp) return *this; 
+    throw new AzException("AzBmatStore =", "no support"); 
+  }
+}; 
+
 //! binary matrix 
+/*-------------------------------------------------------------------*/
+/* The on-rows of all the columns share one chunked array (CSR by   */
+/* column).  A column dense enough that a bitmap of #row bits is     */
+/* smaller than its row list is kept as a bitmap instead.  Cleared   */
+/* columns leave holes, which are squeezed out when they dominate.   */
+/*-------------------------------------------------------------------*/
 class AzBmat {
 protected:
   int row_num; 
-  AzDataArray<AzIntArr> a; 
+  int col_num; 
+  AzBmatCol *cols; 
+  AzBaseArray<AzBmatCol> a_cols; 
+  AzBmatStore ia_rows;  /* row lists of the columns */
+  AzBmatStore ia_bits;  /* bitmaps of the columns; 32 rows per int */
+  AzInt64 hole_num;     /* #ints in ia_rows and ia_bits no longer in use */
 
 public: 
-  AzBmat() : row_num(0) {}
-  AzBmat(int inp_row_num, int inp_col_num) : row_num(0) {
-    resize(inp_col_num); 
+  AzBmat() : row_num(0), col_num(0), cols(NULL), hole_num(0) {}
+  AzBmat(int inp_row_num, int inp_col_num) 
+    : row_num(0), col_num(0), cols(NULL), hole_num(0) {
+    reform(inp_row_num, inp_col_num); 
   }
-  AzBmat(const AzBmat *inp) : row_num(0) {
+  AzBmat(const AzBmat *inp) 
+    : row_num(0), col_num(0), cols(NULL), hole_num(0) {
     set(inp);   
   }
-  inline void set(const AzBmat *inp) {
-    row_num = inp->row_num; 
-    a.reset(&inp->a); 
-  }
-  AzBmat(const AzBmat &inp) : row_num(0) {
+  AzBmat(const AzBmat &inp) 
+    : row_num(0), col_num(0), cols(NULL), hole_num(0) {
     set(&inp); 
   }
   AzBmat & operator =(const AzBmat &inp) {
@@ -46,43 +105,72 @@ public:
     set(&inp);  
     return *this; 
   }
+  void set(const AzBmat *inp); 
+
   inline void reform(int inp_row_num, int inp_col_num) {
     reset(); 
     row_num = inp_row_num;  
     resize(inp_col_num); 
   }
-  inline void resize(int new_col_num) {
-    a.resz(new_col_num); 
-  }
+  void resize(int new_col_num); 
 
   inline void reset() {
+    a_cols.free(&cols); col_num = 0; 
+    ia_rows.reset(); 
+    ia_bits.reset(); 
+    hole_num = 0; 
     row_num = 0; 
-    a.reset(); 
   }
   inline int rowNum() const {
     return row_num; 
   }
   inline int colNum() const {
-    return a.cursor(); 
+    return col_num; 
   }
-
-  inline const AzIntArr *on_rows(int col) const {
-    return a.point(col); 
+  AzInt64 memSize() const {
+    return (AzInt64)a_cols.size()*sizeof(AzBmatCol) + 
+           ia_rows.memSize() + ia_bits.memSize(); 
   }
-  inline void clear(int fx) {
-    a.point_u(fx)->reset(); 
+
+  inline int count(int col) const {
+    checkCol(col, "AzBmat::count"); 
+    return cols[col].num; 
   }
+  void on_rows(int col, AzIntArr *ia_on_rows) const; /* output */
+  void clear(int col); 
+  void load(int col, const AzIntArr *ia_on_rows); 
 
-  inline void load(int col, const AzIntArr *ia_on_rows) {
-    if (ia_on_rows == NULL || ia_on_rows->size() <= 0) return; 
+  /*---  p[row] += val for the on-rows of the column  ---*/
+  inline void add_to(int col, double val, double *p) const {
+    checkCol(col, "AzBmat::add_to"); 
+    const AzBmatCol *cp = &cols[col]; 
+    if (cp->num <= 0) return; 
+    if (!cp->isBits) {
+      const int *rows = ia_rows.point(cp->chunk, cp->offs); 
+      int ix; 
+      for (ix = 0; ix < cp->num; ++ix) p[rows[ix]] += val; 
+      return; 
+    }
+    const int *bits = ia_bits.point(cp->chunk, cp->offs); 
+    int wx, w_num = wordNum(); 
+    for (wx = 0; wx < w_num; ++wx) {
+      unsigned int word = (unsigned int)bits[wx]; 
+      int row = wx*32; 
+      for ( ; word != 0; word >>= 1, ++row) {
+        if (word & 1) p[row] += val; 
+      }
+    }
+  }
 
-    if (ia_on_rows->min() < 0 || 
-        ia_on_rows->max() >= row_num) {
-      throw new AzException("AzBmat::load", "wrong row#"); 
+protected:
+  inline int wordNum() const {
+    return (row_num+31)/32; 
+  }
+  inline void checkCol(int col, const char *eyec) const {
+    if (col < 0 || col >= col_num) {
+      throw new AzException(eyec, "col# is out of range"); 
     }
-    a.point_u(col)->reset(ia_on_rows); 
   }
+  void squeeze(); 
 }; 
-#endif 
-
-
+#endif
@@ -170,19 +170,52 @@ void AzDmat::_transpose(AzDmat *m_out,
   }
 }
 
+/*-------------------------------------------------------------*/
+/*---  functor for AzSmat::scan_by_rows  ---*/
+class AzDmat_FillRows {
+public:
+  double **out_col; /* indexed by input row# */
+  AzDmat_FillRows(double **inp) : out_col(inp) {}
+  inline void operator()(int rx, int cx, double val) {
+    out_col[rx][cx] = val; 
+  }
+}; 
+
 /*-------------------------------------------------------------*/
 void AzDmat::transpose_from(const AzSmat *m_inp)
+{
+  _transpose_from(m_inp, NULL); 
+}
+
+/*-------------------------------------------------------------*/
+void AzDmat::transpose_from_destroy(AzSmat *m_inp)
+{
+  _transpose_from(m_inp, m_inp); 
+  m_inp->reset(); 
+}
+
+/*-------------------------------------------------------------*/
+void AzDmat::_transpose_from(const AzSmat *m_inp, 
+                             AzSmat *m_to_destroy) /* may be NULL */
 {
   reform(m_inp->colNum(), m_inp->rowNum()); 
-  int cx; 
-  for (cx = 0; cx < m_inp->colNum(); ++cx) {
-    const AzSvect *v_inp = m_inp->col(cx); 
-    AzCursor cursor; 
-    for ( ; ; ) {
-      double val; 
-      int rx = v_inp->next(cursor, val); 
-      if (rx < 0) break; 
-      set(cx, rx, val); 
+  double **out_col = NULL; 
+  AzBaseArray<double *> _a(col_num, &out_col); 
+  int rx; 
+  for (rx = 0; rx < col_num; ++rx) out_col[rx] = column[rx]->point_u(); 
+  AzDmat_FillRows fill(out_col); 
+
+  /*---  by blocks of columns so that the input can be released as we go  ---*/
+  int inp_col_num = m_inp->colNum(); 
+  int block_size = inp_col_num; 
+  if (m_to_destroy != NULL) block_size = MAX(1, (inp_col_num+7)/8); 
+  int col_b; 
+  for (col_b = 0; col_b < inp_col_num; col_b += block_size) {
+    int col_e = MIN(inp_col_num, col_b + block_size); 
+    m_inp->scan_by_rows(col_b, col_e, fill); 
+    if (m_to_destroy != NULL) {
+      int cx; 
+      for (cx = col_b; cx < col_e; ++cx) m_to_destroy->destroy(cx); 
     }
   }
 }
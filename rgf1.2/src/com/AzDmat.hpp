@@ -55,6 +55,13 @@ public:
     initialize(inp); 
     if (coeff != 1) multiply(coeff); 
   }
+  /*---  take over the contents of inp; inp becomes empty  ---*/
+  void transfer_from(AzDvect *inp) {
+    if (inp == this) return; 
+    a.transfer_from(&inp->a, &elm, &inp->elm, "AzDvect::transfer_from"); 
+    num = inp->num; 
+    inp->num = 0; 
+  }
 
   AzDvect(const AzDvect &inp) : num(0), elm(NULL) {
     initialize(&inp); 
@@ -110,6 +117,7 @@ public:
 
   inline int size() const { return num; }
   inline int rowNum() const { return num; }  
+  inline AzInt64 memSize() const { return (AzInt64)a.size()*sizeof(double); }
 
   inline void destroy() {
     _release();  
@@ -358,6 +366,7 @@ public:
 
   void transpose(AzDmat *m_out, int col_begin = -1, int col_end = -1); 
   void transpose_from(const AzSmat *m_inp); 
+  void transpose_from_destroy(AzSmat *m_inp); /* m_inp is destroyed along the way */
 
   void cut(double min_val); 
 
@@ -398,6 +407,14 @@ public:
 
   inline int rowNum() const { return row_num; }
   inline int colNum() const { return col_num; }
+  AzInt64 memSize() const {
+    AzInt64 size = (AzInt64)col_num*sizeof(AzDvect *); 
+    int col; 
+    for (col = 0; col < col_num; ++col) {
+      if (column[col] != NULL) size += sizeof(AzDvect) + column[col]->memSize(); 
+    }
+    return size; 
+  }
 
   void normalize(); 
   void normalize1(); 
@@ -441,6 +458,7 @@ protected:
   void initialize(const AzReadOnlyMatrix *inp); 
 
   void _transpose(AzDmat *m_out, int col_begin, int col_end); 
+  void _transpose_from(const AzSmat *m_inp, AzSmat *m_to_destroy); 
 }; 
 
 #endif 
@@ -76,6 +76,16 @@ public:
     if (str3 != NULL) s3 << str3; 
   }
 
+  /*---  to carry an exception out of a parallel region, where it can't be thrown:  ---*/
+  /*---  keep the first one and discard the rest; rethrow it after the region      ---*/
+  static void keepFirst(AzException *e, AzException **first) {
+#pragma omp critical (AzException_keepFirst)
+    {
+      if (*first == NULL) *first = e; 
+      else                delete e; 
+    }
+  }
+
   AzRetCode getReturnCode() {
     return retcode;   
   }
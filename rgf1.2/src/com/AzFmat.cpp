@@ -0,0 +1,154 @@
+/* * * * *
+ *  AzFmat.cpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#include "AzFmat.hpp"
+
+/*-------------------------------------------------------------*/
+void AzFvect::_read(AzFile *file) 
+{
+  const char *eyec = "AzFvect::_read"; 
+  if (elm != NULL || num != 0) {
+    throw new AzException(eyec, "(elm=NULL,num=0) was expected"); 
+  }
+  num = file->readInt(); 
+  a.alloc(&elm, num, eyec, "elm"); 
+  file->seekReadBytes(-1, sizeof(elm[0])*num, elm); 
+  _swap(); 
+}
+
+/*-------------------------------------------------------------*/
+void AzFvect::_swap()
+{
+  if (!isSwapNeeded) return; 
+  int ex; 
+  for (ex = 0; ex < num; ++ex) {
+    AzFile::swap_val(&elm[ex]); 
+  }
+}
+
+/*-------------------------------------------------------------*/
+/* same format as AzDvect when AZ_MTX_FLOAT is double */
+int AzFvect::write(AzFile *file) 
+{
+  int io_len = 0; 
+  io_len += file->writeInt(num); 
+  if (num > 0) {
+    _swap(); 
+    io_len += file->writeBytes(elm, sizeof(elm[0])*num); 
+    _swap(); 
+  }
+  return io_len; 
+}
+
+/*-------------------------------------------------------------*/
+void AzFmat::reform(int new_row_num, int new_col_num)
+{
+  const char *eyec = "AzFmat::reform"; 
+  if (new_col_num < 0 || new_row_num < 0) {
+    throw new AzException(eyec, "# columns or row must be non-negative"); 
+  }
+  _release(); 
+  col_num = new_col_num; 
+  row_num = new_row_num; 
+  a.alloc(&column, col_num, eyec, "column"); 
+  int cx; 
+  for (cx = 0; cx < col_num; ++cx) {
+    column[cx] = new AzFvect(row_num); 
+  }
+}
+
+/*-------------------------------------------------------------*/
+void AzFmat::transpose_from(const AzSmat *m_inp)
+{
+  _transpose_from(m_inp, NULL); 
+}
+
+/*-------------------------------------------------------------*/
+void AzFmat::transpose_from_destroy(AzSmat *m_inp)
+{
+  _transpose_from(m_inp, m_inp); 
+  m_inp->reset(); 
+}
+
+/*-------------------------------------------------------------*/
+/*---  functor for AzSmat::scan_by_rows  ---*/
+class AzFmat_FillRows {
+public:
+  AZ_MTX_FLOAT **out_col; /* indexed by input row# */
+  AzFmat_FillRows(AZ_MTX_FLOAT **inp) : out_col(inp) {}
+  inline void operator()(int rx, int cx, double val) {
+    out_col[rx][cx] = (AZ_MTX_FLOAT)val; 
+  }
+}; 
+
+/*-------------------------------------------------------------*/
+void AzFmat::_transpose_from(const AzSmat *m_inp, 
+                             AzSmat *m_to_destroy) /* may be NULL */
+{
+  reform(m_inp->colNum(), m_inp->rowNum()); 
+  AZ_MTX_FLOAT **out_col = NULL; 
+  AzBaseArray<AZ_MTX_FLOAT *> _a(col_num, &out_col); 
+  int rx; 
+  for (rx = 0; rx < col_num; ++rx) out_col[rx] = column[rx]->point_u(); 
+  AzFmat_FillRows fill(out_col); 
+
+  /*---  by blocks of columns so that the input can be released as we go  ---*/
+  int inp_col_num = m_inp->colNum(); 
+  int block_size = inp_col_num; 
+  if (m_to_destroy != NULL) block_size = MAX(1, (inp_col_num+7)/8); 
+  int col_b; 
+  for (col_b = 0; col_b < inp_col_num; col_b += block_size) {
+    int col_e = MIN(inp_col_num, col_b + block_size); 
+    m_inp->scan_by_rows(col_b, col_e, fill); 
+    if (m_to_destroy != NULL) {
+      int cx; 
+      for (cx = col_b; cx < col_e; ++cx) m_to_destroy->destroy(cx); 
+    }
+  }
+}
+
+/*-------------------------------------------------------------*/
+void AzFmat::read(AzFile *file) 
+{
+  const char *eyec = "AzFmat::read"; 
+  _release(); 
+  col_num = file->readInt(); 
+  row_num = file->readInt(); 
+  if (col_num > 0) {
+    a.alloc(&column, col_num, eyec, "column"); 
+    int cx; 
+    for (cx = 0; cx < col_num; ++cx) {
+      column[cx] = AzObjIOTools::read<AzFvect>(file); 
+      if (column[cx] == NULL) column[cx] = new AzFvect(row_num); 
+    }
+  }
+}
+
+/*-------------------------------------------------------------*/
+/* same format as AzDmat when AZ_MTX_FLOAT is double */
+int AzFmat::write(AzFile *file) 
+{
+  int io_len = 0; 
+  io_len += file->writeInt(col_num); 
+  io_len += file->writeInt(row_num); 
+  int cx; 
+  for (cx = 0; cx < col_num; ++cx) {
+    io_len += AzObjIOTools::write(column[cx], file); 
+  }
+  return io_len; 
+}
@@ -0,0 +1,229 @@
+/* * * * *
+ *  AzFmat.hpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_FMAT_HPP_
+#define _AZ_FMAT_HPP_
+
+#include "AzUtil.hpp"
+#include "AzSmat.hpp"
+#include "AzDmat.hpp"
+
+/*------------------------------------------------------------*/
+/* Dense vector/matrix for storing large arrays of values in   */
+/* AZ_MTX_FLOAT (single precision if built with _AZ_FLOAT32_). */
+/* Arithmetic is done in double; only the storage differs.     */
+/*------------------------------------------------------------*/
+
+//! dense vector for storage
+class AzFvect {
+protected:
+  int num; 
+  AZ_MTX_FLOAT *elm; 
+  AzBaseArray<AZ_MTX_FLOAT> a; 
+
+  void _release() {
+    a.free(&elm); num = 0; 
+  }
+
+public:
+  AzFvect() : num(0), elm(NULL) {}
+  AzFvect(int inp_num) : num(0), elm(NULL) {
+    reform(inp_num); 
+  }
+  AzFvect(const AzFvect *inp) : num(0), elm(NULL) {
+    set(inp); 
+  }
+  AzFvect(AzFile *file) : num(0), elm(NULL) {
+    _read(file); 
+  }
+  ~AzFvect() {}
+
+  void read(AzFile *file) {
+    _release(); 
+    _read(file); 
+  }
+  int write(AzFile *file); 
+
+  void reform(int new_num) {
+    if (new_num < 0) {
+      throw new AzException("AzFvect::reform", "dim must be non-negative"); 
+    }
+    if (new_num != num || elm == NULL) {
+      _release(); 
+      num = new_num; 
+      a.alloc(&elm, num, "AzFvect::reform", "elm"); 
+    }
+    set((double)0); 
+  }
+  inline void reset() {
+    _release(); 
+  }
+  void set(double val) {
+    int ex; 
+    for (ex = 0; ex < num; ++ex) elm[ex] = (AZ_MTX_FLOAT)val; 
+  }
+  void set(const AzFvect *inp) {
+    if (inp == this) return; 
+    if (inp->num != num) {
+      _release(); 
+      num = inp->num; 
+      a.alloc(&elm, num, "AzFvect::set", "elm"); 
+    }
+    int ex; 
+    for (ex = 0; ex < num; ++ex) elm[ex] = inp->elm[ex]; 
+  }
+  void set(const AzDvect *inp) {
+    if (inp->rowNum() != num) {
+      _release(); 
+      num = inp->rowNum(); 
+      a.alloc(&elm, num, "AzFvect::set(dvect)", "elm"); 
+    }
+    const double *val = inp->point(); 
+    int ex; 
+    for (ex = 0; ex < num; ++ex) elm[ex] = (AZ_MTX_FLOAT)val[ex]; 
+  }
+
+  inline int rowNum() const { return num; }
+  inline const AZ_MTX_FLOAT *point() const { return elm; }
+  inline AZ_MTX_FLOAT *point_u() { return elm; }
+  inline double get(int row) const {
+    if (row < 0 || row >= num) {
+      throw new AzException("AzFvect::get", "row# is out of range"); 
+    }
+    return elm[row]; 
+  }
+  inline void set(int row, double val) {
+    if (row < 0 || row >= num) {
+      throw new AzException("AzFvect::set", "row# is out of range"); 
+    }
+    elm[row] = (AZ_MTX_FLOAT)val; 
+  }
+  inline AzInt64 memSize() const {
+    return (AzInt64)a.size()*sizeof(AZ_MTX_FLOAT); 
+  }
+
+  /*---  component-wise multiplication  ---*/
+  void scale(const AzDvect *inp) {
+    checkDim(inp->rowNum(), "AzFvect::scale"); 
+    const double *val = inp->point(); 
+    int ex; 
+    for (ex = 0; ex < num; ++ex) elm[ex] = (AZ_MTX_FLOAT)(elm[ex]*val[ex]); 
+  }
+
+  /*---  sums are accumulated in double  ---*/
+  double sum() const {
+    double sum = 0; 
+    int ex; 
+    for (ex = 0; ex < num; ++ex) sum += elm[ex]; 
+    return sum; 
+  }
+  double sum(const int *dxs, int dxs_num) const {
+    double sum = 0; 
+    int ix; 
+    for (ix = 0; ix < dxs_num; ++ix) sum += elm[dxs[ix]]; 
+    return sum; 
+  }
+  double sum(const AzIntArr *ia_dx) const {
+    if (ia_dx == NULL) return sum(); 
+    return sum(ia_dx->point(), ia_dx->size()); 
+  }
+  double absSum() const {
+    double sum = 0; 
+    int ex; 
+    for (ex = 0; ex < num; ++ex) sum += fabs((double)elm[ex]); 
+    return sum; 
+  }
+  double maxAbs() const {
+    double max_abs = 0; 
+    int ex; 
+    for (ex = 0; ex < num; ++ex) max_abs = MAX(max_abs, fabs((double)elm[ex])); 
+    return max_abs; 
+  }
+  double max() const {
+    if (num <= 0) return 0; 
+    double max_val = elm[0]; 
+    int ex; 
+    for (ex = 1; ex < num; ++ex) max_val = MAX(max_val, (double)elm[ex]); 
+    return max_val; 
+  }
+  double min() const {
+    if (num <= 0) return 0; 
+    double min_val = elm[0]; 
+    int ex; 
+    for (ex = 1; ex < num; ++ex) min_val = MIN(min_val, (double)elm[ex]); 
+    return min_val; 
+  }
+
+protected:
+  void _read(AzFile *file); 
+  void _swap(); 
+  inline void checkDim(int inp_num, const char *eyec) const {
+    if (inp_num != num) throw new AzException(eyec, "dimensionality conflict"); 
+  }
+}; 
+
+//! dense matrix for storage
+class AzFmat {
+protected:
+  int col_num, row_num; 
+  AzFvect **column; 
+  AzObjPtrArray<AzFvect> a; 
+
+  void _release() {
+    a.free(&column); col_num = 0; 
+    row_num = 0; 
+  }
+
+public:
+  AzFmat() : col_num(0), row_num(0), column(NULL) {}
+  ~AzFmat() {}
+
+  inline void reset() {
+    _release(); 
+  }
+  void reform(int row_num, int col_num); 
+  void transpose_from(const AzSmat *m_inp); 
+  void transpose_from_destroy(AzSmat *m_inp); /* m_inp is destroyed along the way */
+
+  void read(AzFile *file); 
+  int write(AzFile *file); 
+
+  inline int rowNum() const { return row_num; }
+  inline int colNum() const { return col_num; }
+  inline const AzFvect *col(int cx) const {
+    if (cx < 0 || cx >= col_num) {
+      throw new AzException("AzFmat::col", "col# is out of range"); 
+    }
+    return column[cx]; 
+  }
+  inline double get(int row, int cx) const {
+    return col(cx)->get(row); 
+  }
+  AzInt64 memSize() const {
+    AzInt64 size = (AzInt64)col_num*sizeof(AzFvect *); 
+    int cx; 
+    for (cx = 0; cx < col_num; ++cx) {
+      if (column[cx] != NULL) size += sizeof(AzFvect) + column[cx]->memSize(); 
+    }
+    return size; 
+  }
+
+protected:
+  void _transpose_from(const AzSmat *m_inp, AzSmat *m_to_destroy); 
+}; 
+#endif
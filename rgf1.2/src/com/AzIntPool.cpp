@@ -20,8 +20,14 @@
 #include "AzUtil.hpp"
 #include "AzIntPool.hpp"
 #include "AzPrint.hpp"
+#include "AzSort.hpp"
 
 int rkj_compare_IP_ent(const void *v1, const void *v2); 
+class AzIpEnt_Less { public: 
+  inline bool operator()(const AzIpEnt &e1, const AzIpEnt &e2) const {
+    return (rkj_compare_IP_ent(&e1, &e2) < 0); 
+  }
+}; 
 
 /*------------------------------------------------------------------*/
 void AzIntPool::_read(AzFile *file) 
@@ -208,7 +214,7 @@ void AzIntPool::commit()
     ent[ex].ints = data + ent[ex].offs; 
   }
 
-  qsort(ent, ent_num, sizeof(ent[0]), rkj_compare_IP_ent); 
+  AzSort::introsort(ent, ent_num, AzIpEnt_Less()); 
 
   int out_num = 0; 
   int new_id = 0; 
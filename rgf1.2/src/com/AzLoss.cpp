@@ -17,6 +17,7 @@
  * * * * */
 
 #include "AzLoss.hpp"
+#include "AzLossSimd.hpp"
 
 /*--------------------------------------------------------*/
 double AzLoss::getLoss(AzLossType loss_type, 
@@ -132,6 +133,32 @@ AzLosses AzLoss::getLosses(AzLossType loss_type,
   return o; 
 }
 
+#ifdef _AZ_SIMD_LOSS_
+/*------------------------------------------------------------------*/
+/* false if the loss type has no SIMD kernel */
+static bool simd_sum_deriv(AzLossType loss_type, 
+                           const int *dxs, int dx_num, 
+                           const double *p, const double *y, const double *dw, 
+                           double py_avg, 
+                           double &nega_dL, double &ddL) 
+{
+  if (loss_type == AzLoss_Square || loss_type == AzLoss_LS) {
+    az_simd_sum_deriv<AzLossSimd_LS>(dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL); 
+  }
+  else if (loss_type == AzLoss_Expo) {
+    az_simd_sum_deriv<AzLossSimd_Expo>(dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL); 
+  }
+  else if (loss_type == AzLoss_Logistic1) {
+    az_simd_sum_deriv<AzLossSimd_Logistic<1> >(dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL); 
+  }
+  else if (loss_type == AzLoss_Logistic2) {
+    az_simd_sum_deriv<AzLossSimd_Logistic<2> >(dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL); 
+  }
+  else return false; 
+  return true; 
+}
+#endif
+
 /*------------------------------------------------------------------*/
 /* 
  * This is for speeding up AzOptOntTree.  It's the same as calling 
@@ -148,6 +175,9 @@ void AzLoss::sum_deriv(AzLossType loss_type,
                        double &nega_dL, 
                        double &ddL) 
 {
+#ifdef _AZ_SIMD_LOSS_
+  if (simd_sum_deriv(loss_type, dxs, dx_num, p, y, NULL, py_avg, nega_dL, ddL)) return; 
+#endif
   nega_dL = 0; 
   ddL = 0; 
   if (loss_type == AzLoss_Square || 
@@ -202,6 +232,9 @@ void AzLoss::sum_deriv_weighted(AzLossType loss_type,
                        double &nega_dL, 
                        double &ddL) 
 {
+#ifdef _AZ_SIMD_LOSS_
+  if (simd_sum_deriv(loss_type, dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL)) return; 
+#endif
   nega_dL = 0; 
   ddL = 0; 
   if (loss_type == AzLoss_Square || 
@@ -239,6 +272,210 @@ void AzLoss::sum_deriv_weighted(AzLossType loss_type,
   }
 }
 
+/*------------------------------------------------------------------*/
+/* 
+ * Same as calling sum_deriv(_weighted) for each group but in one 
+ * sequential pass over the data points. 
+ */
+void AzLoss::sum_deriv_by_id(AzLossType loss_type, 
+                       const unsigned short *ids, 
+                       int data_num, 
+                       int id_num, 
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, 
+                       double py_avg, 
+                       /*---  output  ---*/
+                       double *nega_dL, 
+                       double *ddL, 
+                       int *count, 
+                       const double *id_offs) /* may be NULL */
+{
+  int dx; 
+  if (loss_type == AzLoss_Square || 
+      loss_type == AzLoss_LS) {
+    for (dx = 0; dx < data_num; ++dx) {
+      int id = ids[dx]; 
+      if (id >= id_num) continue; 
+      ++count[id]; 
+      double pp = p[dx]; 
+      if (id_offs != NULL) pp += id_offs[id]; 
+      if (dw == NULL) {
+        nega_dL[id] += (y[dx]-pp); 
+      }
+      else {
+        nega_dL[id] += dw[dx]*(y[dx]-pp); 
+        ddL[id] += dw[dx]; 
+      }
+    }
+    if (dw == NULL) {
+      int id; 
+      for (id = 0; id < id_num; ++id) ddL[id] = (double)count[id]; 
+    }
+  }
+  else if (loss_type == AzLoss_Expo) {
+    for (dx = 0; dx < data_num; ++dx) {
+      int id = ids[dx]; 
+      if (id >= id_num) continue; 
+      ++count[id]; 
+      double pp = p[dx]; 
+      if (id_offs != NULL) pp += id_offs[id]; 
+      double py = pp*y[dx]; 
+      py -= py_avg; /* for numerical stability */
+      double ee = my_exp(-py); 
+      if (dw != NULL) ee *= dw[dx]; 
+      ddL[id] += ee;            /* exp(-py)*y*y */
+      nega_dL[id] += y[dx]*ee;  /* exp(-py)*y */
+    }
+  }
+  else {
+    for (dx = 0; dx < data_num; ++dx) {
+      int id = ids[dx]; 
+      if (id >= id_num) continue; 
+      ++count[id]; 
+      double pp = p[dx]; 
+      if (id_offs != NULL) pp += id_offs[id]; 
+      AzLosses o = getLosses(loss_type, pp, y[dx], py_avg); 
+      if (dw != NULL) {
+        o.loss2 *= dw[dx]; 
+        o._loss1 *= dw[dx]; 
+      }
+      ddL[id] += o.loss2; 
+      nega_dL[id] += o._loss1; 
+    }
+  }
+}
+
+/*------------------------------------------------------------------*/
+double AzLoss::sum_loss(AzLossType loss_type, 
+                        int data_num, 
+                        const double *p, 
+                        const double *y, 
+                        const double *dw, /* may be NULL */
+                        double py_adjust) 
+{
+#ifdef _AZ_SIMD_LOSS_
+  if (loss_type == AzLoss_Square || loss_type == AzLoss_LS) {
+    return az_simd_sum_loss<AzLossSimd_LS>(data_num, p, y, dw, py_adjust); 
+  }
+  else if (loss_type == AzLoss_Expo) {
+    return az_simd_sum_loss<AzLossSimd_Expo>(data_num, p, y, dw, py_adjust); 
+  }
+  else if (loss_type == AzLoss_Logistic1) {
+    return az_simd_sum_loss<AzLossSimd_Logistic<1> >(data_num, p, y, dw, py_adjust); 
+  }
+  else if (loss_type == AzLoss_Logistic2) {
+    return az_simd_sum_loss<AzLossSimd_Logistic<2> >(data_num, p, y, dw, py_adjust); 
+  }
+#endif
+  double loss_sum = 0; 
+  int dx; 
+  for (dx = 0; dx < data_num; ++dx) {
+    double loss = getLoss(loss_type, p[dx], y[dx], py_adjust); 
+    if (dw != NULL) loss *= dw[dx]; 
+    loss_sum += loss; 
+  }
+  return loss_sum; 
+}
+
+/*------------------------------------------------------------------*/
+void AzLoss::sum_deriv_par(AzLossType loss_type, 
+                       const int *dxs, 
+                       int dx_num, 
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, /* may be NULL */
+                       double py_avg, 
+                       /*---  output  ---*/
+                       double &nega_dL, 
+                       double &ddL) 
+{
+  int chunk_num = (dx_num+par_chunk_size-1)/par_chunk_size; 
+  if (chunk_num <= 1) {
+    if (dw == NULL) sum_deriv(loss_type, dxs, dx_num, p, y, py_avg, nega_dL, ddL); 
+    else sum_deriv_weighted(loss_type, dxs, dx_num, p, y, dw, py_avg, nega_dL, ddL); 
+    return; 
+  }
+  AzDvect v_nega_dL(chunk_num), v_ddL(chunk_num); 
+  double *c_nega_dL = v_nega_dL.point_u(), *c_ddL = v_ddL.point_u(); 
+  int cx; 
+  AzException *err = NULL; 
+#pragma omp parallel for schedule(dynamic)
+  for (cx = 0; cx < chunk_num; ++cx) {
+    try {
+      int ix = cx*par_chunk_size; 
+      int num = MIN(par_chunk_size, dx_num - ix); 
+      if (dw == NULL) sum_deriv(loss_type, dxs+ix, num, p, y, py_avg, c_nega_dL[cx], c_ddL[cx]); 
+      else sum_deriv_weighted(loss_type, dxs+ix, num, p, y, dw, py_avg, c_nega_dL[cx], c_ddL[cx]); 
+    }
+    catch (AzException *e) {
+      AzException::keepFirst(e, &err); 
+    }
+  }
+  if (err != NULL) throw err; 
+  nega_dL = ddL = 0; 
+  for (cx = 0; cx < chunk_num; ++cx) {
+    nega_dL += c_nega_dL[cx]; 
+    ddL += c_ddL[cx]; 
+  }
+}
+
+/*------------------------------------------------------------------*/
+void AzLoss::sum_deriv_by_id_par(AzLossType loss_type, 
+                       const unsigned short *ids, 
+                       int data_num, 
+                       int id_num, 
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, /* may be NULL */
+                       double py_avg, 
+                       /*---  output  ---*/
+                       double *nega_dL, 
+                       double *ddL, 
+                       int *count, 
+                       const double *id_offs) /* may be NULL */
+{
+  const int chunk_max = 64; /* bounds the work area */
+  int chunk_size = MAX(par_chunk_size, (data_num+chunk_max-1)/chunk_max); 
+  int chunk_num = (data_num+chunk_size-1)/chunk_size; 
+  if (chunk_num <= 1) {
+    sum_deriv_by_id(loss_type, ids, data_num, id_num, p, y, dw, py_avg, 
+                    nega_dL, ddL, count, id_offs); 
+    return; 
+  }
+  AzDmat m_nega_dL(id_num, chunk_num), m_ddL(id_num, chunk_num); 
+  AzIntArr ia_count; 
+  ia_count.reset(id_num*chunk_num, 0); 
+  int cx; 
+  AzException *err = NULL; 
+#pragma omp parallel for schedule(dynamic)
+  for (cx = 0; cx < chunk_num; ++cx) {
+    try {
+      int dx = cx*chunk_size; 
+      int num = MIN(chunk_size, data_num - dx); 
+      sum_deriv_by_id(loss_type, ids+dx, num, id_num, p+dx, y+dx, 
+                      (dw == NULL) ? NULL : dw+dx, py_avg, 
+                      m_nega_dL.col_u(cx)->point_u(), m_ddL.col_u(cx)->point_u(), 
+                      ia_count.point_u()+id_num*cx, id_offs); 
+    }
+    catch (AzException *e) {
+      AzException::keepFirst(e, &err); 
+    }
+  }
+  if (err != NULL) throw err; 
+  const int *c_count = ia_count.point(); 
+  for (cx = 0; cx < chunk_num; ++cx) {
+    const double *c_nega_dL = m_nega_dL.col(cx)->point(); 
+    const double *c_ddL = m_ddL.col(cx)->point(); 
+    int id; 
+    for (id = 0; id < id_num; ++id) {
+      nega_dL[id] += c_nega_dL[id]; 
+      ddL[id] += c_ddL[id]; 
+      count[id] += c_count[id_num*cx+id]; 
+    }
+  }
+}
+
 /*------------------------------------------------------------------*/
 void AzLoss::help_lines(int level, AzDataPool<AzBytArr> *pool_desc) {
   AzIntArr ia_l_type; 
@@ -308,6 +545,78 @@ double AzLoss::negativeDeriv12(AzLossType loss_type,
                            double *out_py_adjust, 
                            AzDvect *v_1,  /* -L' */
                            AzDvect *v_2)  /* L'' */
+{
+  return _negativeDeriv12(loss_type, v_p, v_y, ia_dx, out_py_adjust, v_1, v_2); 
+}
+
+/*------------------------------------------------------------------*/
+double AzLoss::negativeDeriv12(AzLossType loss_type, 
+                           const AzDvect *v_p, 
+                           const AzDvect *v_y, 
+                           const AzIntArr *ia_dx, /* may be NULL */
+                           /*---  output  ---*/
+                           double *out_py_adjust, 
+                           AzFvect *v_1,  /* -L' */
+                           AzFvect *v_2)  /* L'' */
+{
+  return _negativeDeriv12(loss_type, v_p, v_y, ia_dx, out_py_adjust, v_1, v_2); 
+}
+
+/*------------------------------------------------------------------*/
+/* T: double or AZ_MTX_FLOAT */
+template <class T, class T2>
+static void fill_deriv12(AzLossType loss_type, 
+                         const double *p, const double *y, 
+                         const AzIntArr *ia_dx, /* may be NULL */
+                         int data_num, 
+                         double py_adjust, 
+                         /*---  output  ---*/
+                         T *out1,   /* -L' */
+                         T2 *out2)  /* L''; may be NULL */
+{
+  const int *dxs = NULL; 
+  int dx_num = data_num; 
+  if (ia_dx != NULL) {
+    dxs = ia_dx->point(&dx_num); 
+  }
+#ifdef _AZ_SIMD_LOSS_
+  if (loss_type == AzLoss_Square || loss_type == AzLoss_LS) {
+    az_simd_fill_deriv<AzLossSimd_LS>(dxs, dx_num, p, y, py_adjust, out1, out2); return; 
+  }
+  else if (loss_type == AzLoss_Expo) {
+    az_simd_fill_deriv<AzLossSimd_Expo>(dxs, dx_num, p, y, py_adjust, out1, out2); return; 
+  }
+  else if (loss_type == AzLoss_Logistic1) {
+    az_simd_fill_deriv<AzLossSimd_Logistic<1> >(dxs, dx_num, p, y, py_adjust, out1, out2); return; 
+  }
+  else if (loss_type == AzLoss_Logistic2) {
+    az_simd_fill_deriv<AzLossSimd_Logistic<2> >(dxs, dx_num, p, y, py_adjust, out1, out2); return; 
+  }
+#endif
+  int ix; 
+  for (ix = 0; ix < dx_num; ++ix) {
+    int dx = ix; 
+    if (dxs != NULL) dx = dxs[ix]; 
+
+    AzLosses o; 
+    o = AzLoss::getLosses(loss_type, p[dx], y[dx], py_adjust); 
+    out1[dx] = (T)o._loss1; 
+    if (out2 != NULL) {
+      out2[dx] = (T2)o.loss2; 
+    }
+  }
+}
+
+/*------------------------------------------------------------------*/
+template <class V>
+double AzLoss::_negativeDeriv12(AzLossType loss_type, 
+                           const AzDvect *v_p, 
+                           const AzDvect *v_y, 
+                           const AzIntArr *ia_dx, /* may be NULL */
+                           /*---  output  ---*/
+                           double *out_py_adjust, 
+                           V *v_1,  /* -L' */
+                           V *v_2)  /* L'' */
 {
   const double *p = v_p->point(); 
   const double *y = v_y->point(); 
@@ -333,32 +642,16 @@ double AzLoss::negativeDeriv12(AzLossType loss_type,
   if (v_1->rowNum() != data_num) {
     v_1->reform(data_num); 
   }
-  double *out1 = v_1->point_u(); 
-  
-  double *out2 = NULL; 
   if (v_2 != NULL) {
     if (v_2->rowNum() != data_num) {
       v_2->reform(data_num); 
     }
-    out2 = v_2->point_u(); 
+    fill_deriv12(loss_type, p, y, ia_dx, data_num, py_adjust, 
+                 v_1->point_u(), v_2->point_u()); 
   }
-
-  const int *dxs = NULL; 
-  int dx_num = data_num; 
-  if (ia_dx != NULL) {
-    dxs = ia_dx->point(&dx_num); 
-  }
-  int ix; 
-  for (ix = 0; ix < dx_num; ++ix) {
-    int dx = ix; 
-    if (dxs != NULL) dx = dxs[ix]; 
-
-    AzLosses o; 
-    o = getLosses(loss_type, p[dx], y[dx], py_adjust); 
-    out1[dx] = o._loss1; 
-    if (out2 != NULL) {
-      out2[dx] = o.loss2; 
-    }
+  else {
+    fill_deriv12(loss_type, p, y, ia_dx, data_num, py_adjust, 
+                 v_1->point_u(), (double *)NULL); 
   }
 
   double lam_scale = 1; 
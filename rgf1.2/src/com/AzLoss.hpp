@@ -21,6 +21,7 @@
 
 #include "AzUtil.hpp"
 #include "AzDmat.hpp"
+#include "AzFmat.hpp"
 
 enum AzLossType {
   /*---  for classification  ---*/
@@ -118,12 +119,60 @@ public:
                        double &nega_dL, 
                        double &ddL); 
 
+  static void sum_deriv_by_id(AzLossType loss_type, 
+                       const unsigned short *ids, /* [data point]: group id */
+                       int data_num, 
+                       int id_num, /* points with id >= id_num are skipped */
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, /* may be NULL */
+                       double py_avg, 
+                       /*---  output: [id], must be zeroed by the caller  ---*/
+                       double *nega_dL, 
+                       double *ddL, 
+                       int *count, 
+                       const double *id_offs=NULL); /* [id]: added to p; may be NULL */
+
+  /*---  Multi-threaded versions of the above.  The data is cut into  ---*/
+  /*---  chunks of fixed size whose sums are added in the order of    ---*/
+  /*---  chunks, so the results don't depend on the number of threads. ---*/
+  static const int par_chunk_size = 1024*32; 
+  static void sum_deriv_par(AzLossType loss_type, 
+                       const int *dxs, 
+                       int dx_num, 
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, /* may be NULL */
+                       double py_avg, 
+                       /*---  output  ---*/
+                       double &nega_dL, 
+                       double &ddL); 
+  static void sum_deriv_by_id_par(AzLossType loss_type, 
+                       const unsigned short *ids, 
+                       int data_num, 
+                       int id_num, 
+                       const double *p, 
+                       const double *y, 
+                       const double *dw, /* may be NULL */
+                       double py_avg, 
+                       /*---  output: [id], must be zeroed by the caller  ---*/
+                       double *nega_dL, 
+                       double *ddL, 
+                       int *count, 
+                       const double *id_offs=NULL); /* [id]: added to p; may be NULL */
+
   static AzLosses getLosses(AzLossType loss_type, 
                             double p, double y, 
                             double py_adjust=0); 
   static double getLoss(AzLossType loss_type,
                         double p_val, double y_val, 
                         double py_adjust=0); 
+  static double sum_loss(AzLossType loss_type, 
+                        int data_num, 
+                        const double *p, 
+                        const double *y, 
+                        const double *dw, /* may be NULL */
+                        double py_adjust=0); 
 
   /*---  ---*/
   static void help_lines(int level, AzDataPool<AzBytArr> *pool_desc); 
@@ -136,6 +185,14 @@ public:
                            double *out_py_adjust, 
                            AzDvect *v_1,  /* -L' */
                            AzDvect *v_2); /* L'' */
+  static double negativeDeriv12(AzLossType loss_type, 
+                           const AzDvect *v_p, 
+                           const AzDvect *v_y,  
+                           const AzIntArr *ia_dx, //!< NULL: all 
+                           /*---  output  ---*/
+                           double *out_py_adjust, 
+                           AzFvect *v_1,  /* -L' */
+                           AzFvect *v_2); /* L'' */
 
   inline static const char *lossName(AzLossType loss_type) {
     if (loss_type < 0 || loss_type >= AzLossType_Num) {
@@ -143,6 +200,15 @@ public:
     }
     return loss_str[loss_type]; 
   }
+
+protected:
+  /*---  V: AzDvect or AzFvect  ---*/
+  template <class V>
+  static double _negativeDeriv12(AzLossType loss_type, 
+                           const AzDvect *v_p, const AzDvect *v_y, 
+                           const AzIntArr *ia_dx, 
+                           double *out_py_adjust, 
+                           V *v_1, V *v_2); 
 }; 
 
 #endif 
@@ -24,6 +24,28 @@
 #define myMIN(x,y) (((x) < (y)) ? (x) : (y))
 #define myMAX(x,y) (((x) > (y)) ? (x) : (y))
 
+/*---------------------------------------------------------------*/
+/* AzPod<T>::yes is 1 if T is trivially copyable and has no      */
+/* constructor; AzBaseArray keeps such types in malloc'ed memory */
+/* so that it can grow by realloc (no copy if grown in place).   */
+/* Declare a plain struct with AzDeclarePod after its typedef.   */
+/*---------------------------------------------------------------*/
+template<class T> struct AzPod { enum { yes = 0 }; }; 
+template<class T> struct AzPod<T *> { enum { yes = 1 }; }; 
+#define AzDeclarePod(T) template<> struct AzPod<T> { enum { yes = 1 }; }; 
+AzDeclarePod(char)
+AzDeclarePod(unsigned char)
+AzDeclarePod(short)
+AzDeclarePod(unsigned short)
+AzDeclarePod(int)
+AzDeclarePod(unsigned int)
+AzDeclarePod(long)
+AzDeclarePod(unsigned long)
+AzDeclarePod(long long)
+AzDeclarePod(unsigned long long)
+AzDeclarePod(float)
+AzDeclarePod(double)
+
 
 /*-----  templates for memory handling  ---*/
 /*--------------------------------------------------------------*/
@@ -31,6 +53,7 @@
 /* AzBaseArray    Yes     anything that can be copied by "="   */
 /* AzObjArray     Yes     objects; realloc uses "transfer_from */
 /* AzObjPtrArray  Yes     ptr to object                        */
+/* AzObjPool      Yes     objects handed out and taken back    */
 /*--------------------------------------------------------------*/
 
 /*-----------------------------------------------------*/
@@ -84,6 +107,37 @@ public:
     *ptr = new_ptr;  
   }
 
+  /*---  for AzPod types only; memory from these must be released by free_pod  ---*/
+  template <class T>
+  static void alloc_pod(T **ptr, int num, const char *eyec="AzMemTools::alloc_pod", 
+                        const char *errmsg="") {
+    *ptr = NULL; 
+    if (num <= 0) return; 
+    *ptr = (T *)::malloc(sizeof(T)*(size_t)num); 
+    if (*ptr == NULL) throw new AzException(AzAllocError, eyec, errmsg, "malloc", num); 
+  }
+  template <class T>
+  static void free_pod(T **ptr) {
+    if (*ptr == NULL) return; 
+    ::free(*ptr); 
+    *ptr = NULL; 
+  }
+  /*---  contents are kept up to min(old,new); no copy if grown in place  ---*/
+  template <class T>
+  static void realloc_pod(T **ptr, int new_num, 
+                          const char *eyec="AzMemTools::realloc_pod", 
+                          const char *errmsg="") {
+    if (new_num <= 0) {
+      free_pod(ptr); 
+      return; 
+    }
+    T *new_ptr = (T *)::realloc(*ptr, sizeof(T)*(size_t)new_num); 
+    if (new_ptr == NULL) { /* *ptr is still valid */
+      throw new AzException(AzAllocError, eyec, errmsg, "realloc", new_num); 
+    }
+    *ptr = new_ptr; 
+  }
+
   /*---  use this for the classes that cannot be copied by = ---*/
   /*---  "transfer_from" function must be defined  ---*/
   template <class T>
@@ -214,6 +268,19 @@ public:
     num = new_num;
     *p = a; 
   }
+  void transfer_from(AzObjPtrArray<T> *inp, 
+                     T ***p, T ***inp_p, 
+                     const char *eyec="AzObjPtrArray::transfer_from", const char *msg="") 
+  {
+    if (p==NULL || *p!=a || inp_p==NULL || *inp_p!=inp->a) {
+      err("sync-check failed", eyec, msg); 
+    }
+    AzPMemTools::free(&a, num); num = 0; /* free this data */
+    a = inp->a; inp->a = NULL;     /* transfer data from inp to this */
+    num = inp->num; inp->num = 0;  
+    *p = a;          /* synch ptr for this */
+    *inp_p = inp->a; /* synch ptr for inp */
+  }
   void free(T ***p, 
             const char *eyec="AzObjPtrArrary::free", const char *msg="") {
     if (p==NULL || *p!=a) {
@@ -232,6 +299,37 @@ protected:
   }
 };
 
+/*---------------------------------------------------------------------*/
+/* Memory handling of AzBaseArray, chosen at compile time by AzPod so  */
+/* that malloc/realloc are never instantiated for non-POD types.       */
+/*---------------------------------------------------------------------*/
+template<class T, int isPod>
+struct AzBaseMem {
+  static void alloc(T **ptr, int num, const char *eyec, const char *msg) {
+    AzMemTools::alloc(ptr, num, eyec, msg); 
+  }
+  static void realloc(T **ptr, int old_num, int new_num, 
+                      const char *eyec, const char *msg) {
+    AzMemTools::realloc_base<T>(ptr, old_num, new_num, eyec, msg); 
+  }
+  static void free(T **ptr) {
+    AzMemTools::free(ptr); 
+  }
+}; 
+template<class T>
+struct AzBaseMem<T, 1> {
+  static void alloc(T **ptr, int num, const char *eyec, const char *msg) {
+    AzMemTools::alloc_pod(ptr, num, eyec, msg); 
+  }
+  static void realloc(T **ptr, int /* old_num */, int new_num, 
+                      const char *eyec, const char *msg) {
+    AzMemTools::realloc_pod<T>(ptr, new_num, eyec, msg); 
+  }
+  static void free(T **ptr) {
+    AzMemTools::free_pod(ptr); 
+  }
+}; 
+
 /*-----------------------------------------------------*/
 template<class T>
 class AzBaseArray  /* expandable array of base type that can be copied by memcpy */
@@ -245,7 +343,7 @@ public:
   }
   AzBaseArray() : a(NULL), num(0) {}
   ~AzBaseArray() {
-    AzMemTools::free(&a); 
+    _free(); 
   }
   void alloc(T **p, int inp_num, 
              const char *eyec="AzBaseArrary::alloc", const char *msg="") {
@@ -255,17 +353,30 @@ public:
     }
     num = inp_num; 
     if (num > 0) {
-      AzMemTools::alloc(&a, num, eyec, msg); 
+      AzBaseMem<T, AzPod<T>::yes>::alloc(&a, num, eyec, msg); 
     }
     *p = a; 
   }
   void realloc(T **p, int new_num, 
              const char *eyec="AzBaseArrary::realloc", const char *msg="") {
     if (p==NULL || *p!=a) err("sync-check failed", eyec, msg);
-    AzMemTools::realloc_base<T>(&a, num, new_num, eyec, msg); 
+    AzBaseMem<T, AzPod<T>::yes>::realloc(&a, num, new_num, eyec, msg); 
     num = new_num;
     *p = a; 
   }
+  /*---  make room for at least min_num; grow geometrically  ---*/
+  inline void reserve(T **p, int min_num, 
+             const char *eyec="AzBaseArrary::reserve", const char *msg="") {
+    if (min_num <= num) return; 
+    realloc(p, grow_size(num, min_num), eyec, msg); 
+  }
+  /*---  x2 while small, x1.5 after that  ---*/
+  static inline int grow_size(int cur_num, int min_num) {
+    int new_num = (cur_num < 1024*1024) ? cur_num*2 : cur_num + cur_num/2; 
+    if (new_num < cur_num) new_num = 0x7fffffff; /* overflow */
+    new_num = myMAX(new_num, 32); 
+    return myMAX(new_num, min_num); 
+  }
   void transfer_from(AzBaseArray<T> *inp, 
                      T **p, T **inp_p, 
                      const char *eyec="AzBaseArray::transfer_from", const char *msg="") 
@@ -273,7 +384,7 @@ public:
     if (p==NULL || *p!=a || inp_p==NULL || *inp_p!=inp->a) {
       err("sync-check failed", eyec, msg); 
     }
-    AzMemTools::free(&a); num = 0; /* free this data */
+    _free();                       /* free this data */
     a = inp->a; inp->a = NULL;     /* transfer data from inp to this */
     num = inp->num; inp->num = 0;  
     *p = a;          /* synch ptr for this */
@@ -283,13 +394,17 @@ public:
             const char *eyec="AzBaseArray::free", const char *msg="") {
     if (p==NULL || *p!=a) err("sync-check failed", eyec, msg); 
     if (a != NULL) {
-      AzMemTools::free(&a); num = 0; 
+      _free(); 
       *p = a; 
     }
   }
   inline int size() const { return num; }
   inline T *array() { return a; }
 protected:
+  inline void _free() {
+    AzBaseMem<T, AzPod<T>::yes>::free(&a); 
+    num = 0; 
+  }
   void err(const char *s1, const char *s2, const char *s3) {
     throw new AzException(s1, s2, s3); 
   }
@@ -355,4 +470,79 @@ protected:
     throw new AzException(s1, s2, s3); 
   }
 };
+
+/*-----------------------------------------------------*/
+/* Pool of objects allocated in slabs (arena).         */
+/* get() hands out an object; put() takes it back for  */
+/* reuse after calling its reset(); release() frees    */
+/* everything at once.  The slabs grow geometrically   */
+/* so that n objects cost O(log n) allocations.        */
+/* T must have a default constructor and reset().      */
+/*-----------------------------------------------------*/
+template<class T>
+class AzObjPool
+{
+protected:
+  T **slab;  AzBaseArray<T *> a_slab; 
+  int slab_num; 
+
+  T **avail; AzBaseArray<T *> a_avail;  /* free list */
+  int avail_num; 
+  int obj_num; 
+  int min_slab_size; 
+
+public:
+  AzObjPool(int inp_min_slab_size=64) : slab(NULL), slab_num(0), 
+      avail(NULL), avail_num(0), obj_num(0), min_slab_size(inp_min_slab_size) {}
+  ~AzObjPool() {
+    release(); 
+  }
+  inline T *get() {
+    if (avail_num <= 0) _grow(); 
+    --avail_num; 
+    return avail[avail_num]; 
+  }
+  /*---  obj must have been obtained by get() of this pool  ---*/
+  inline void put(T *obj) {
+    if (obj == NULL) return; 
+    if (avail_num >= obj_num) {
+      throw new AzException("AzObjPool::put", "more objects than allocated?!"); 
+    }
+    obj->reset(); 
+    avail[avail_num++] = obj; 
+  }
+  void release() {
+    int sx; 
+    for (sx = 0; sx < slab_num; ++sx) {
+      AzMemTools::free(&slab[sx]); 
+    }
+    a_slab.free(&slab); 
+    slab_num = 0; 
+    a_avail.free(&avail); 
+    avail_num = obj_num = 0; 
+  }
+  inline int size() const { return obj_num; }   /* #allocated */
+  inline int inUse() const { return obj_num - avail_num; }
+
+protected:
+  void _grow() {
+    const char *eyec = "AzObjPool::_grow"; 
+    int num = myMAX(min_slab_size, obj_num); /* double the total */
+    if (slab_num >= a_slab.size()) {
+      int new_size = myMAX(8, slab_num*2); 
+      a_slab.realloc(&slab, new_size, eyec, "slab"); 
+    }
+    AzMemTools::alloc(&slab[slab_num], num, eyec, "objects"); 
+    ++slab_num; 
+
+    /*---  everything was in use; the free list holds the new ones only  ---*/
+    a_avail.free(&avail); 
+    a_avail.alloc(&avail, obj_num+num, eyec, "avail"); 
+    T *ptr = slab[slab_num-1]; 
+    int ix; 
+    for (ix = 0; ix < num; ++ix) avail[ix] = ptr + (num-1-ix); 
+    avail_num = num; 
+    obj_num += num; 
+  }
+}; 
 #endif 
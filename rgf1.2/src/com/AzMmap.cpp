@@ -0,0 +1,83 @@
+/* * * * *
+ *  AzMmap.cpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+/*---  64-bit file offsets on 32-bit systems; must come before the system headers  ---*/
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "AzMmap.hpp"
+
+#ifndef _WIN32
+#define _AZ_USE_MMAP_
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+/*------------------------------------------------------------------*/
+bool AzMmap::map(AzFile *file, AzInt64 offs, AzInt64 len)
+{
+  unmap(); 
+#ifdef _AZ_USE_MMAP_
+  if (file == NULL || file->ptr() == NULL || offs < 0 || len <= 0) return false; 
+  int fd = fileno(file->ptr()); 
+  AzInt64 page = (AzInt64)sysconf(_SC_PAGESIZE); 
+  if (page <= 0) return false; 
+  AzInt64 aligned = offs / page * page; 
+  AzInt64 my_len = len + (offs - aligned); 
+  if ((AzInt64)(size_t)my_len != my_len) return false; /* too large for this address space */
+
+  int flags = MAP_SHARED; 
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE; /* fault in the pages now instead of one at a time */
+#endif
+  void *ptr = mmap(NULL, (size_t)my_len, PROT_READ, flags, fd, (off_t)aligned); 
+  if (ptr == MAP_FAILED) return false; 
+  base = ptr; 
+  base_len = (size_t)my_len; 
+  data = (const AzByte *)base + (offs - aligned); 
+  return true; 
+#else
+  return false; 
+#endif
+}
+
+/*------------------------------------------------------------------*/
+void AzMmap::unmap()
+{
+#ifdef _AZ_USE_MMAP_
+  if (base != NULL) {
+    munmap(base, base_len); 
+  }
+#endif
+  base = NULL; 
+  base_len = 0; 
+  data = NULL; 
+}
+
+/*------------------------------------------------------------------*/
+/* static */
+void AzMmap::prefetch(AzFile *file, AzInt64 offs, AzInt64 len)
+{
+#if defined(_AZ_USE_MMAP_) && defined(POSIX_FADV_WILLNEED)
+  if (file == NULL || file->ptr() == NULL || offs < 0 || len <= 0) return; 
+  posix_fadvise(fileno(file->ptr()), (off_t)offs, (off_t)len, POSIX_FADV_WILLNEED); 
+#endif
+}
@@ -0,0 +1,59 @@
+/* * * * *
+ *  AzMmap.hpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_MMAP_HPP_
+#define _AZ_MMAP_HPP_
+
+#include "AzUtil.hpp"
+
+//! Read-only mapping of a region of a file.  
+/*-------------------------------------------------------------*/
+/* map() returns false where memory mapping is not available   */
+/* (e.g., Windows build) so that the caller can read instead.  */
+/* The region must have been flushed to the file beforehand.   */
+/* prefetch() asks the OS to start reading a region in the     */
+/* background; it returns immediately.                         */
+/*-------------------------------------------------------------*/
+class AzMmap {
+protected:
+  void *base; 
+  size_t base_len; 
+  const AzByte *data; 
+
+public:
+  AzMmap() : base(NULL), base_len(0), data(NULL) {}
+  ~AzMmap() { unmap(); }
+
+  bool map(AzFile *file, AzInt64 offs, AzInt64 len); 
+  void unmap(); 
+  inline bool isMapped() const { return (data != NULL); }
+  inline const AzByte *point() const { return data; }
+
+  static void prefetch(AzFile *file, AzInt64 offs, AzInt64 len); 
+
+  /*---  prohibit =  ---*/
+  AzMmap & operator =(const AzMmap &inp) {
+    if (this == &inp) return *this; 
+    throw new AzException("AzMmap =", "copying AzMmap is prohibited"); 
+  }
+
+private: 
+  /*---  not implemented: two copies would unmap the same region  ---*/
+  AzMmap(const AzMmap &); 
+}; 
+#endif 
@@ -0,0 +1,192 @@
+/* * * * *
+ *  AzPackedIntArr.cpp 
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#include "AzPackedIntArr.hpp"
+
+/*-------------------------------------------------------------------*/
+void AzPackedIntArr::pack(const int *ints, int num)
+{
+  const char *eyec = "AzPackedIntArr::pack"; 
+  reset(); 
+  if (num <= 0) return; 
+
+  /*---  worst case: 4 bytes per value plus the block headers  ---*/
+  int max_bytes = num*4 + (num/block_size+1)*5 + 8; 
+  a_bytes.alloc(&bytes, max_bytes, eyec, "bytes"); 
+
+  AzByte *out = bytes; 
+  unsigned int zz[block_size]; 
+  int bx; 
+  for (bx = 0; bx < num; bx += block_size) {
+    const int *in = ints + bx; 
+    int cnt = MIN(block_size, num - bx); 
+
+    /*---  zigzag differences and the bit width to hold them  ---*/
+    unsigned int z_or = 0; 
+    int ix; 
+    for (ix = 1; ix < cnt; ++ix) {
+      unsigned int d = (unsigned int)in[ix] - (unsigned int)in[ix-1]; /* no overflow */
+      unsigned int z = (d << 1) ^ (0 - (d >> 31)); 
+      zz[ix] = z; 
+      z_or |= z; 
+    }
+    int width = 0; 
+    for ( ; z_or != 0; z_or >>= 1) ++width; 
+
+    /*---  header  ---*/
+    unsigned int first = (unsigned int)in[0]; 
+    *out++ = (AzByte)(first); 
+    *out++ = (AzByte)(first >> 8); 
+    *out++ = (AzByte)(first >> 16); 
+    *out++ = (AzByte)(first >> 24); 
+    *out++ = (AzByte)width; 
+
+    /*---  bit-packing  ---*/
+    if (width == 0) continue; 
+    unsigned long long acc = 0; 
+    int acc_bits = 0; 
+    for (ix = 1; ix < cnt; ++ix) {
+      acc |= (unsigned long long)zz[ix] << acc_bits; 
+      acc_bits += width; 
+      for ( ; acc_bits >= 8; acc_bits -= 8) {
+        *out++ = (AzByte)acc; 
+        acc >>= 8; 
+      }
+    }
+    if (acc_bits > 0) {
+      *out++ = (AzByte)acc; 
+    }
+  }
+
+  byte_num = (int)(out - bytes); 
+  if (byte_num > max_bytes) {
+    throw new AzException(eyec, "buffer overflow"); 
+  }
+  a_bytes.realloc(&bytes, byte_num, eyec, "shrink"); 
+  int_num = num; 
+}
+
+/*-------------------------------------------------------------------*/
+int AzPackedIntArr::write(AzFile *file) const
+{
+  int len = file->writeInt(int_num); 
+  len += file->writeInt(byte_num); 
+  if (byte_num > 0) len += file->writeBytes(bytes, byte_num); 
+  return len; 
+}
+
+/*-------------------------------------------------------------------*/
+void AzPackedIntArr::read(AzFile *file) 
+{
+  const char *eyec = "AzPackedIntArr::read"; 
+  reset(); 
+  int num = file->readInt(); 
+  int bnum = file->readInt(); 
+  if (num < 0 || bnum < 0) {
+    throw new AzException(eyec, "corrupted"); 
+  }
+  if (bnum > 0) {
+    a_bytes.alloc(&bytes, bnum, eyec, "bytes"); 
+    file->seekReadBytes(-1, bnum, bytes); 
+  }
+  int_num = num; 
+  byte_num = bnum; 
+}
+
+/*-------------------------------------------------------------------*/
+/* Each value is taken from an unaligned 8-byte window starting at the */
+/* byte its bits begin in; near the end of the input, where the window */
+/* would go past it, bytes are fed one at a time.  Width <= 32 so the  */
+/* bits of a value fit in the window after the shift (<= 7).           */
+/*-------------------------------------------------------------------*/
+void AzPackedIntArr::unpack(const AzByte *inp_bytes, int inp_byte_num, 
+                            int inp_int_num, int *out_ints) 
+{
+  const char *eyec = "AzPackedIntArr::unpack"; 
+  const AzByte *in = inp_bytes; 
+  const AzByte *in_end = inp_bytes + inp_byte_num; 
+  int bx; 
+  for (bx = 0; bx < inp_int_num; bx += block_size) {
+    int *out = out_ints + bx; 
+    int cnt = MIN(block_size, inp_int_num - bx); 
+    if (in + 5 > in_end) {
+      throw new AzException(eyec, "corrupted"); 
+    }
+    unsigned int first = (unsigned int)in[0] | ((unsigned int)in[1] << 8) | 
+                         ((unsigned int)in[2] << 16) | ((unsigned int)in[3] << 24); 
+    int width = in[4]; 
+    in += 5; 
+
+    unsigned int prev = first; 
+    out[0] = (int)prev; 
+    int ix; 
+    if (width == 0) {
+      for (ix = 1; ix < cnt; ++ix) out[ix] = (int)prev; 
+      continue; 
+    }
+    if (width > 32) {
+      throw new AzException(eyec, "corrupted"); 
+    }
+    AzInt64 blk_bytes = ((AzInt64)(cnt-1)*width + 7) / 8; 
+    if (blk_bytes > in_end - in) {
+      throw new AzException(eyec, "corrupted"); 
+    }
+    unsigned long long mask = ((unsigned long long)1 << width) - 1; 
+    ix = 1; 
+#ifndef _AZ_BIG_ENDIAN_
+    /*---  fast path: 8-byte windows while they stay within the input  ---*/
+    int fast_end = cnt; 
+    if (in_end - in < blk_bytes + 8) {
+      AzInt64 safe_bits = ((AzInt64)(in_end - in) - 8) * 8; /* a window may start up to here */
+      fast_end = (safe_bits < 0) ? 1 : (int)MIN((AzInt64)cnt, 2 + safe_bits/width); 
+    }
+    int bitpos = 0; 
+    for ( ; ix < fast_end; ++ix, bitpos += width) {
+      unsigned long long win; 
+      memcpy(&win, in + (bitpos >> 3), sizeof(win)); 
+      unsigned int z = (unsigned int)((win >> (bitpos & 7)) & mask); 
+      prev += (z >> 1) ^ (0 - (z & 1)); 
+      out[ix] = (int)prev; 
+    }
+    if (ix >= cnt) {
+      in += blk_bytes; 
+      continue; 
+    }
+    /*---  the rest one byte at a time; continue from bitpos  ---*/
+    const AzByte *my_in = in + (bitpos >> 3); 
+    int skip = bitpos & 7; 
+    unsigned long long acc = (unsigned long long)(*my_in++) >> skip; 
+    int acc_bits = 8 - skip; 
+#else
+    const AzByte *my_in = in; 
+    unsigned long long acc = 0; 
+    int acc_bits = 0; 
+#endif
+    for ( ; ix < cnt; ++ix) {
+      for ( ; acc_bits < width; acc_bits += 8) {
+        acc |= (unsigned long long)(*my_in++) << acc_bits; 
+      }
+      unsigned int z = (unsigned int)(acc & mask); 
+      acc >>= width; 
+      acc_bits -= width; 
+      prev += (z >> 1) ^ (0 - (z & 1)); 
+      out[ix] = (int)prev; 
+    }
+    in += blk_bytes; 
+  }
+}
@@ -0,0 +1,76 @@
+/* * * * *
+ *  AzPackedIntArr.hpp 
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_PACKED_INT_ARR_HPP_
+#define _AZ_PACKED_INT_ARR_HPP_
+
+#include "AzUtil.hpp"
+
+//! Compact read-only copy of an int array: block delta + bit-packing.  
+/*-------------------------------------------------------------------*/
+/* 
+ * Each block of (up to) 128 integers is stored as 
+ *   - the first value (4 bytes, little-endian), 
+ *   - bit width w (1 byte), 
+ *   - the zigzag-encoded differences from the previous value, w bits each. 
+ * Ascending runs such as data indexes within a leaf cost a few bits per 
+ * value; a change of direction costs only the block it occurs in. 
+ */
+class AzPackedIntArr {
+protected:
+  AzByte *bytes; 
+  AzBaseArray<AzByte> a_bytes; 
+  int byte_num; 
+  int int_num; 
+
+  static const int block_size = 128; 
+
+public:
+  AzPackedIntArr() : bytes(NULL), byte_num(0), int_num(0) {}
+  AzPackedIntArr(const int *ints, int num) : bytes(NULL), byte_num(0), int_num(0) {
+    pack(ints, num); 
+  }
+  void reset() {
+    a_bytes.free(&bytes); 
+    byte_num = int_num = 0; 
+  }
+  void pack(const int *ints, int num); 
+  inline void pack(const AzIntArr *ia) {
+    pack(ia->point(), ia->size()); 
+  }
+  inline void unpack(int *out_ints) const { /* must have size() entries */
+    unpack(bytes, byte_num, int_num, out_ints); 
+  }
+  inline void unpack(AzIntArr *ia) const {
+    ia->reset(int_num, 0); 
+    if (int_num > 0) unpack(ia->point_u()); 
+  }
+
+  /*---  int_num, byte_num, bytes  ---*/
+  int write(AzFile *file) const; 
+  void read(AzFile *file); 
+
+  /*---  decode what write() wrote, e.g., from a mapped file  ---*/
+  static void unpack(const AzByte *inp_bytes, int inp_byte_num, 
+                     int inp_int_num, int *out_ints); 
+
+  inline int size() const { return int_num; }
+  inline int byteNum() const { return byte_num; }
+}; 
+
+#endif 
@@ -17,6 +17,9 @@
  * * * * */
 
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "AzUtil.hpp"
 #include "AzSmat.hpp"
 #include "AzPrint.hpp"
@@ -169,47 +172,112 @@ void AzSmat::transpose(AzSmat *m_out,
 }
 
 /*-------------------------------------------------------------*/
-void AzSmat::_transpose(AzSmat *m_out, 
-                        int col_begin, 
-                        int col_end) const
-{
-  int row_num = rowNum(); 
+/*---  functors for scan_by_rows  ---*/
+class AzSmat_CountRows {
+public:
+  int *row_count; 
+  AzSmat_CountRows(int *inp) : row_count(inp) {}
+  inline void operator()(int rx, int /* cx */, double /* val */) {
+    ++row_count[rx]; 
+  }
+}; 
+class AzSmat_FillRows {
+public:
+  AzSvect **out_col; /* indexed by input row# */
+  int col_offs; 
+  AzSmat_FillRows(AzSvect **inp, int offs) : out_col(inp), col_offs(offs) {}
+  inline void operator()(int rx, int cx, double val) {
+    out_col[rx]->set_inOrder(cx - col_offs, val); 
+  }
+}; 
 
-  m_out->reform(col_end - col_begin, row_num); 
+/*-------------------------------------------------------------*/
+int AzSmat::threadNum(int col_b, int col_e) const
+{
+#ifdef _OPENMP
+  double nz_num = 0; 
+  int cx; 
+  for (cx = col_b; cx < col_e; ++cx) {
+    if (column[cx] != NULL) {
+      int num; 
+      column[cx]->point(&num); 
+      nz_num += num; 
+    }
+  }
+  if (nz_num >= 1024*64 && row_num > 1) return omp_get_max_threads(); 
+#endif
+  return 1; 
+}
 
+/*-------------------------------------------------------------*/
+/* rows of columns [col_b,col_e) of m_inp become the columns of m_out; */
+/* m_out must have been formed.                                        */
+static void az_transpose_block(const AzSmat *m_inp, int col_b, int col_e, 
+                               int col_offs, 
+                               AzSmat *m_out, 
+                               bool doKeep) /* keep the elements of m_out */
+{
+  int row_num = m_inp->rowNum(); 
   AzIntArr ia_row_count; 
   ia_row_count.reset(row_num, 0); 
-  int *row_count = ia_row_count.point_u(); 
-
-  int cx; 
-  for (cx = col_begin; cx < col_end; ++cx) {
-    /* rewind(cx); */
-    AzCursor cursor; 
-    for ( ; ; ) {
-      double val; 
-      int rx = next(cursor, cx, val); 
-      if (rx < 0) break;
+  AzSmat_CountRows count(ia_row_count.point_u()); 
+  m_inp->scan_by_rows(col_b, col_e, count); 
 
-      ++row_count[rx]; 
-    }
-  }
+  AzSvect **out_col = NULL; 
+  AzBaseArray<AzSvect *> _a(row_num, &out_col); 
+  const int *row_count = ia_row_count.point(); 
   int rx; 
   for (rx = 0; rx < row_num; ++rx) {
-    if (row_count[rx] > 0) {
-      m_out->col_u(rx)->clear_prepare(row_count[rx]); 
-    }
+    if (row_count[rx] <= 0) continue; 
+    out_col[rx] = m_out->col_u(rx); 
+    if (doKeep) out_col[rx]->prepare_more(row_count[rx]); 
+    else        out_col[rx]->clear_prepare(row_count[rx]); 
   }
+  AzSmat_FillRows fill(out_col, col_offs); 
+  m_inp->scan_by_rows(col_b, col_e, fill); 
+}
 
-  for (cx = col_begin; cx < col_end; ++cx) {
-    /* rewind(cx); */
-    AzCursor cursor; 
-    for ( ; ; ) {
-      double val; 
-      int rx = next(cursor, cx, val); 
-      if (rx < 0) break;
+/*-------------------------------------------------------------*/
+void AzSmat::_transpose(AzSmat *m_out, 
+                        int col_begin, 
+                        int col_end) const
+{
+  m_out->reform(col_end - col_begin, rowNum()); 
+  az_transpose_block(this, col_begin, col_end, col_begin, m_out, false); 
+}
 
-      m_out->col_u(rx)->set_inOrder(cx - col_begin, val); 
-    }
+/*-------------------------------------------------------------*/
+/* Transpose a block of columns at a time, releasing the columns   */
+/* of the block as soon as they are copied.  The rows of m_out grow */
+/* by exactly what each block adds.                                 */
+/*-------------------------------------------------------------*/
+void AzSmat::transpose_destroy(AzSmat *m_out)
+{
+  if (m_out == this) {
+    throw new AzException("AzSmat::transpose_destroy", "output must be another matrix"); 
+  }
+  int inp_row_num = row_num, inp_col_num = col_num; 
+  m_out->reform(inp_col_num, inp_row_num); 
+
+  const int block_num = 8; 
+  int block_size = MAX(1, (inp_col_num+block_num-1)/block_num); 
+  int col_b; 
+  for (col_b = 0; col_b < inp_col_num; col_b += block_size) {
+    int col_e = MIN(inp_col_num, col_b + block_size); 
+    az_transpose_block(this, col_b, col_e, 0, m_out, true); 
+    int cx; 
+    for (cx = col_b; cx < col_e; ++cx) destroy(cx); 
+  }
+  _release(); 
+}
+
+/*-------------------------------------------------------------*/
+void AzSvect::prepare_more(int num)
+{
+  if (num <= 0) return; 
+  int elm_num_max = MIN(row_num, elm_num + num); 
+  if (elm_num_max > a.size()) {
+    a.realloc(&elm, elm_num_max, "AzSvect::prepare_more", "elm"); 
   }
 }
 
@@ -599,16 +667,11 @@ void AzSvect::_swap()
     return; 
   }
 
-  AZI_VECT_ELM dummy; 
-  if (sizeof(dummy.val) != sizeof(double)) {
-    throw new AzException("AzSvect::_swap", "value is not double?!"); 
-  }
-
   int ex; 
   for (ex = 0; ex < elm_num; ++ex) {
     AZI_VECT_ELM *ep = &elm[ex];  
     AzFile::swap_long(&ep->no); 
-    AzFile::swap_double(&ep->val); 
+    AzFile::swap_val(&ep->val); 
   }
 }
 
@@ -1108,6 +1171,18 @@ double AzSvect::get(int row_no) const
   return 0; 
 }
 
+/*-------------------------------------------------------------*/
+int AzSvect::firstPos(int row_no) const
+{
+  int lx = 0, hx = elm_num; 
+  while (lx < hx) {
+    int mx = lx + (hx - lx) / 2; 
+    if (elm[mx].no < row_no) lx = mx + 1; 
+    else                     hx = mx; 
+  }
+  return lx; 
+}
+
 /*-------------------------------------------------------------*/
 int AzSvect::find(int row_no, 
                   int from_this) const
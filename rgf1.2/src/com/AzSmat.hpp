@@ -24,7 +24,13 @@
 #include "AzReadOnlyMatrix.hpp"
 
 /* Changed AZ_MTX_FLOAT from single-precision to double-precision  */
+/* Build with -D_AZ_FLOAT32_ to store the values in single precision */
+/* (training/test data and the targets for node search).           */
+#ifdef _AZ_FLOAT32_
+typedef float AZ_MTX_FLOAT; 
+#else
 typedef double AZ_MTX_FLOAT; 
+#endif
 #define _checkVal(x) 
 /* static double _too_large_ = 16777216; */
 /* static double _too_small_ = -16777216; */
@@ -33,6 +39,7 @@ typedef struct {
   int no; 
   AZ_MTX_FLOAT val; 
 } AZI_VECT_ELM; 
+AzDeclarePod(AZI_VECT_ELM)
 
 class AzSmat; 
 
@@ -88,6 +95,7 @@ public:
   int write(AzFile *file); 
 
   inline int rowNum() const { return row_num; }  
+  inline AzInt64 memSize() const { return (AzInt64)a.size()*sizeof(AZI_VECT_ELM); }
   void load(const AzIntArr *ia_row, double val); 
   void load(AzIFarr *ifa_row_val); 
   bool isZero() const; 
@@ -145,6 +153,14 @@ public:
             int cut_num = -1) const; 
 
   void clear_prepare(int num); 
+  void prepare_more(int num); /* make room for num more elements; keep the current ones */
+
+  /*---  raw elements in ascending order of row#; may include zeroes  ---*/
+  inline const AZI_VECT_ELM *point(int *out_elm_num) const {
+    *out_elm_num = elm_num; 
+    return elm; 
+  }
+  int firstPos(int row_no) const; /* position of the first element whose row# >= row_no */
   bool isSame(const AzSvect *inp) const; 
   void cap(double cap_val); 
 
@@ -221,6 +237,48 @@ public:
   double nonZeroNum(double *ratio) const; 
 
   void transpose(AzSmat *m_out, int col_begin = -1, int col_end = -1) const; 
+
+  /*---  same as transpose, but this is destroyed along the way so that  ---*/
+  /*---  the peak memory use is close to one copy of the matrix          ---*/
+  void transpose_destroy(AzSmat *m_out); 
+
+  /*---  Kernel of the transposes.  The rows are split into ranges that    ---*/
+  /*---  are processed in parallel.  f(row, col, val) is called for each    ---*/
+  /*---  nonzero entry of the columns [col_b,col_e); within a row, in the   ---*/
+  /*---  order of columns.  f must be safe to call for distinct rows        ---*/
+  /*---  concurrently.                                                      ---*/
+  template <class F>
+  void scan_by_rows(int col_b, int col_e, F &f) const {
+    int t_num = threadNum(col_b, col_e); 
+    int chunk_num = (t_num > 1) ? MIN(row_num, t_num*4) : 1; 
+    int chunk_size = (row_num+chunk_num-1)/MAX(chunk_num,1); 
+    int ix; 
+#pragma omp parallel for schedule(dynamic) if(t_num > 1) num_threads(t_num)
+    for (ix = 0; ix < chunk_num; ++ix) {
+      int row_b = ix*chunk_size, row_e = MIN(row_num, row_b+chunk_size); 
+      int cx; 
+      for (cx = col_b; cx < col_e; ++cx) {
+        if (column[cx] == NULL) continue; 
+        int num; 
+        const AZI_VECT_ELM *elm = column[cx]->point(&num); 
+        int ex = (row_b > 0) ? column[cx]->firstPos(row_b) : 0; 
+        for ( ; ex < num && elm[ex].no < row_e; ++ex) {
+          if (elm[ex].val != 0) f(elm[ex].no, cx, elm[ex].val); 
+        }
+      }
+    }
+  }
+
+  /*---  take over the contents of inp; inp becomes empty  ---*/
+  void transfer_from(AzSmat *inp) {
+    if (inp == this) return; 
+    _release(); 
+    a.transfer_from(&inp->a, &column, &inp->column, "AzSmat::transfer_from"); 
+    col_num = inp->col_num; 
+    row_num = inp->row_num; 
+    dummy_zero.reform(row_num); 
+    inp->_release(); 
+  }
   void cut(double min_val); 
 
   void set(const AzSmat *inp); 
@@ -261,6 +319,14 @@ public:
   }
   inline int rowNum() const { return row_num; }
   inline int colNum() const { return col_num; }
+  AzInt64 memSize() const {
+    AzInt64 size = (AzInt64)col_num*sizeof(AzSvect *); 
+    int col; 
+    for (col = 0; col < col_num; ++col) {
+      if (column[col] != NULL) size += sizeof(AzSvect) + column[col]->memSize(); 
+    }
+    return size; 
+  }
 
   void normalize(); 
   void normalize1(); 
@@ -318,6 +384,7 @@ protected:
   void initialize(int row_num, int col_num, bool asDense); 
   void initialize(const AzSmat *inp); 
   void _transpose(AzSmat *m_out, int col_begin, int col_end) const; 
+  int threadNum(int col_b, int col_e) const; /* for scan_by_rows */
 }; 
 
 #endif 
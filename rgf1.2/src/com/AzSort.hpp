@@ -0,0 +1,270 @@
+/* * * * *
+ *  AzSort.hpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_SORT_HPP_
+#define _AZ_SORT_HPP_
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "AzUtil.hpp"
+
+/*--------------------------------------------------------------*/
+/* Sort kernels replacing qsort.  Comparators are function      */
+/* objects so that they are inlined.                            */
+/*                                                              */
+/* radix:     stable LSD radix sort on unsigned 64-bit keys.    */
+/*            Multi-threaded for large arrays.                  */
+/* insertion: stable; for small arrays.                         */
+/* introsort: not stable; quicksort with median-of-3, falling   */
+/*            back to heapsort when recursion gets too deep.    */
+/*            Already sorted input is detected up-front.        */
+/* T must be copyable by memcpy.                                */
+/*--------------------------------------------------------------*/
+class AzSort {
+public:
+  static const int small_num = 32;           /* insertion sort below this */
+  static const int par_min_num = 1024*256;   /* multi-threaded radix above this */
+
+  /*---  order-preserving unsigned keys  ---*/
+  static inline AzUint64 key(double val) {
+    if (val == 0) val = 0; /* -0 and +0 must be equal */
+    AzUint64 u;
+    memcpy(&u, &val, sizeof(u));
+    AzUint64 sign = (AzUint64)1 << 63;
+    if (u & sign) return ~u;
+    return u | sign;
+  }
+  static inline AzUint64 key(int val) {
+    return (AzUint64)((unsigned int)val ^ 0x80000000U);
+  }
+
+  /*--------------------------------------------------------------*/
+  /* K: AzUint64 operator()(const T &) const; only the lowest     */
+  /*    key_bits bits are used.                                   */
+  /* work: scratch space of num elements.                         */
+  template <class T, class K>
+  static void radix(T *ent, int num, const K &kf, int key_bits,
+                    bool isAscending,
+                    T *work)
+  {
+    if (num <= 1) return;
+    AzUint64 all_or = 0, all_and = ~((AzUint64)0);
+    int ix;
+    for (ix = 0; ix < num; ++ix) {
+      AzUint64 k = kf(ent[ix]);
+      all_or |= k; all_and &= k;
+    }
+    AzUint64 diff = all_or ^ all_and; /* bits that aren't constant */
+    if (diff == 0) return;
+
+    int t_num = 1;
+#ifdef _OPENMP
+    if (num >= par_min_num) t_num = omp_get_max_threads();
+#endif
+    AzIntArr ia_count;
+    ia_count.reset(t_num*digit_num, 0);
+    int *count = ia_count.point_u();
+
+    T *src = ent, *dst = work;
+    int shift;
+    for (shift = 0; shift < key_bits; shift += digit_bits) {
+      if (((diff >> shift) & digit_mask) == 0) continue; /* nothing to do */
+      _radix_pass(src, dst, num, kf, shift, isAscending, t_num, count);
+      T *tmp = src; src = dst; dst = tmp;
+    }
+    if (src != ent) {
+      memcpy(ent, src, sizeof(T)*num);
+    }
+  }
+
+  /*--------------------------------------------------------------*/
+  /* L: bool operator()(const T &a, const T &b) const; a < b      */
+  template <class T, class L>
+  static void insertion(T *ent, int num, const L &less) {
+    int ix;
+    for (ix = 1; ix < num; ++ix) {
+      if (!less(ent[ix], ent[ix-1])) continue;
+      T tmp = ent[ix];
+      int jx = ix;
+      for ( ; jx > 0 && less(tmp, ent[jx-1]); --jx) {
+        ent[jx] = ent[jx-1];
+      }
+      ent[jx] = tmp;
+    }
+  }
+
+  /*--------------------------------------------------------------*/
+  template <class T, class L>
+  static void introsort(T *ent, int num, const L &less) {
+    if (num <= 1) return;
+    int ix;
+    for (ix = 1; ix < num; ++ix) {
+      if (less(ent[ix], ent[ix-1])) break;
+    }
+    if (ix >= num) return; /* already sorted */
+
+    int depth_limit = 0;
+    for (ix = num; ix > 0; ix >>= 1) depth_limit += 2;
+    _introsort(ent, num, less, depth_limit);
+    insertion(ent, num, less); /* finish small partitions */
+  }
+
+  /*--------------------------------------------------------------*/
+  static void sort_int(int *ints, int num, bool isAscending) {
+    if (num <= 1) return;
+    if (num < small_num*8) {
+      if (isAscending) introsort(ints, num, IntLess());
+      else             introsort(ints, num, IntGreater());
+      return;
+    }
+    AzBaseArray<int> a_work;
+    int *work = NULL;
+    a_work.alloc(&work, num, "AzSort::sort_int", "work");
+    radix(ints, num, IntKey(), 32, isAscending, work);
+  }
+
+protected:
+  static const int digit_bits = 11;
+  static const int digit_num = 1 << digit_bits;
+  static const AzUint64 digit_mask = (1 << digit_bits) - 1;
+
+  class IntKey { public:
+    inline AzUint64 operator()(const int &v) const { return key(v); }
+  };
+  class IntLess { public:
+    inline bool operator()(const int &a, const int &b) const { return a < b; }
+  };
+  class IntGreater { public:
+    inline bool operator()(const int &a, const int &b) const { return a > b; }
+  };
+
+  template <class T, class K>
+  static inline int _digit(const T &e, const K &kf, int shift, bool isAscending) {
+    int d = (int)((kf(e) >> shift) & digit_mask);
+    if (!isAscending) d = digit_num - 1 - d;
+    return d;
+  }
+
+  /*---  one stable counting-sort pass; each thread does a contiguous chunk  ---*/
+  template <class T, class K>
+  static void _radix_pass(const T *src, T *dst, int num, const K &kf,
+                          int shift, bool isAscending,
+                          int t_num, int *count) {
+    memset(count, 0, sizeof(int)*t_num*digit_num);
+    int chunk = (num + t_num - 1) / t_num;
+    int tx;
+#pragma omp parallel for if(t_num > 1) num_threads(t_num)
+    for (tx = 0; tx < t_num; ++tx) {
+      int *my_count = count + tx*digit_num;
+      int end = MIN(num, (tx+1)*chunk);
+      int ix;
+      for (ix = tx*chunk; ix < end; ++ix) {
+        ++my_count[_digit(src[ix], kf, shift, isAscending)];
+      }
+    }
+
+    /*---  offsets in the order of (digit, thread) to keep it stable  ---*/
+    int offs = 0;
+    int dx;
+    for (dx = 0; dx < digit_num; ++dx) {
+      for (tx = 0; tx < t_num; ++tx) {
+        int cnt = count[tx*digit_num+dx];
+        count[tx*digit_num+dx] = offs;
+        offs += cnt;
+      }
+    }
+
+#pragma omp parallel for if(t_num > 1) num_threads(t_num)
+    for (tx = 0; tx < t_num; ++tx) {
+      int *my_offs = count + tx*digit_num;
+      int end = MIN(num, (tx+1)*chunk);
+      int ix;
+      for (ix = tx*chunk; ix < end; ++ix) {
+        dst[my_offs[_digit(src[ix], kf, shift, isAscending)]++] = src[ix];
+      }
+    }
+  }
+
+  /*---  leaves partitions smaller than small_num for insertion sort  ---*/
+  template <class T, class L>
+  static void _introsort(T *ent, int num, const L &less, int depth_limit) {
+    for ( ; num > small_num; ) {
+      if (depth_limit <= 0) {
+        _heapsort(ent, num, less);
+        return;
+      }
+      --depth_limit;
+
+      /*---  median of three to ent[0]  ---*/
+      int mid = num/2;
+      if (less(ent[mid], ent[0]))     _swap(ent, mid, 0);
+      if (less(ent[num-1], ent[0]))   _swap(ent, num-1, 0);
+      if (less(ent[num-1], ent[mid])) _swap(ent, num-1, mid);
+      _swap(ent, 0, mid);
+
+      /*---  Hoare partition around ent[0]  ---*/
+      int lx = 0, rx = num;
+      for ( ; ; ) {
+        do { ++lx; } while (lx < num && less(ent[lx], ent[0]));
+        do { --rx; } while (less(ent[0], ent[rx]));
+        if (lx >= rx) break;
+        _swap(ent, lx, rx);
+      }
+      _swap(ent, 0, rx);
+
+      /*---  recurse on the smaller side  ---*/
+      int l_num = rx, r_num = num - rx - 1;
+      if (l_num < r_num) {
+        _introsort(ent, l_num, less, depth_limit);
+        ent += rx + 1; num = r_num;
+      }
+      else {
+        _introsort(ent + rx + 1, r_num, less, depth_limit);
+        num = l_num;
+      }
+    }
+  }
+
+  template <class T, class L>
+  static void _heapsort(T *ent, int num, const L &less) {
+    int ix;
+    for (ix = num/2 - 1; ix >= 0; --ix) _sift_down(ent, ix, num, less);
+    for (ix = num - 1; ix > 0; --ix) {
+      _swap(ent, 0, ix);
+      _sift_down(ent, 0, ix, less);
+    }
+  }
+  template <class T, class L>
+  static inline void _sift_down(T *ent, int ix, int num, const L &less) {
+    for ( ; ; ) {
+      int cx = 2*ix + 1;
+      if (cx >= num) break;
+      if (cx+1 < num && less(ent[cx], ent[cx+1])) ++cx;
+      if (!less(ent[ix], ent[cx])) break;
+      _swap(ent, ix, cx);
+      ix = cx;
+    }
+  }
+  template <class T>
+  static inline void _swap(T *ent, int ix, int jx) {
+    T tmp = ent[ix]; ent[ix] = ent[jx]; ent[jx] = tmp;
+  }
+};
+
+#endif
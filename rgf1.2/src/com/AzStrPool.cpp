@@ -19,9 +19,15 @@
 #include "AzUtil.hpp"
 #include "AzStrPool.hpp"
 #include "AzPrint.hpp"
+#include "AzSort.hpp"
 
 int rj_compare_Ent(const void *v1, const void *v2); 
 int rj_compare_EntTmp(const void *v1, const void *v2); 
+class AzSpEnt_Less { public: 
+  inline bool operator()(const AzSpEnt &e1, const AzSpEnt &e2) const {
+    return (rj_compare_Ent(&e1, &e2) < 0); 
+  }
+}; 
 
 static int index_size = 65536; 
 
@@ -304,7 +310,7 @@ void AzStrPool::commit()
   }
 
   /*-----  sort entries by strings  -----*/
-  qsort(ent, ent_num, sizeof(ent[0]), rj_compare_Ent); 
+  AzSort::introsort(ent, ent_num, AzSpEnt_Less()); 
 
   int out_len = 0; 
   int new_id = 0; 
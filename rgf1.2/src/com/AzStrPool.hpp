@@ -30,6 +30,7 @@ public:
   int value; 
   const AzByte *bytes; /* we need this for qsort */
 } AzSpEnt; 
+AzDeclarePod(AzSpEnt)
 
 typedef struct {
   int begin; 
@@ -37,6 +38,7 @@ typedef struct {
   int min_len; 
   int max_len; 
 } AzSpIndex; 
+AzDeclarePod(AzSpIndex)
 
 //! Store byte arrays or strings.  Searchable after committed. 
 class AzStrPool : public virtual AzStrArray {
@@ -220,7 +220,11 @@ void AzSvDataS::readData_Small(const char *data_fn,
 
   AzFile file(data_fn); 
   file.open("rb"); 
-  int file_size = file.size(); 
+  AzInt64 file_size64 = file.size(); 
+  if (file_size64 >= AzSigned32Max) {
+    throw new AzException(AzInputNotValid, eyec, "Use readData_Large for files over 2GB", data_fn); 
+  }
+  int file_size = (int)file_size64; 
   AzBytArr bq_data; 
   AzByte *data = bq_data.reset(file_size+1, 0); 
   file.seekReadBytes(0, file_size, data); 
@@ -287,6 +291,118 @@ void AzSvDataS::readData_Small(const char *data_fn,
   }
 }
 
+/*------------------------------------------------------------------*/
+/* count lines and find the longest one (including '\n') */
+void AzSvDataS::scanData(const char *data_fn, 
+                         /*---  output  ---*/
+                         int &out_data_num, 
+                         int &out_max_len)
+{
+  const char *eyec = "AzSvDataS::scanData"; 
+  int buff_size = 1024*1024; 
+  AzByte *buff = NULL; 
+  AzBaseArray<AzByte> _a(buff_size, &buff); 
+
+  AzFile file(data_fn); 
+  file.open("rb"); 
+  out_data_num = 0; 
+  out_max_len = 0; 
+  AzInt64 line_len = 0; 
+  for ( ; ; ) {
+    int len = file.gets(buff, buff_size); 
+    if (len <= 0) break; 
+    line_len += len; 
+    if (buff[len-1] != '\n') continue; /* the line continues */
+    if (line_len >= AzSigned32Max) {
+      throw new AzException(AzInputNotValid, eyec, "Too long line (over 2GB)", data_fn); 
+    }
+    out_max_len = MAX(out_max_len, (int)line_len); 
+    ++out_data_num; 
+    line_len = 0; 
+  }
+  if (line_len > 0) { /* last line without '\n' */
+    if (line_len >= AzSigned32Max) {
+      throw new AzException(AzInputNotValid, eyec, "Too long line (over 2GB)", data_fn); 
+    }
+    out_max_len = MAX(out_max_len, (int)line_len); 
+    ++out_data_num; 
+  }
+  file.close(); 
+}
+
+/*------------------------------------------------------------------*/
+/* Same as readData_Small, but reads one line at a time so that the */
+/* file size is not limited by the buffer size.                     */
+void AzSvDataS::readData_Large(const char *data_fn, 
+                         int expected_f_num, 
+                         /*---  output  ---*/
+                         AzSmat *m_feat)
+{
+  const char *eyec = "AzSvDataS::readData_Large"; 
+
+  int data_num, max_len; 
+  scanData(data_fn, data_num, max_len); 
+  if (data_num <= 0) {
+    throw new AzException(AzInputNotValid, eyec, "Empty data"); 
+  }
+
+  int buff_size = max_len+2; 
+  AzByte *buff = NULL; 
+  AzBaseArray<AzByte> _a(buff_size, &buff); 
+
+  AzFile file(data_fn); 
+  file.open("rb"); 
+  int len = readLine(&file, buff, buff_size); 
+  AzBytArr s_first_line(buff, len); 
+  int f_num = if_sparse(s_first_line, expected_f_num); 
+  bool isSparse = false; 
+  if (f_num > 0) {
+    isSparse = true; 
+    --data_num; /* b/c 1st line is information */
+    if (data_num <= 0) {
+      throw new AzException(AzInputNotValid, eyec, "Empty sparse data file"); 
+    }
+    len = readLine(&file, buff, buff_size); 
+  }
+  else {
+    f_num = expected_f_num; 
+    if (f_num <= 0) {
+      f_num = countFeatures(buff, buff+len); 
+    }
+    if (f_num <= 0) {
+      throw new AzException(AzInputNotValid, eyec, "No feature in the first line"); 
+    }
+  }
+
+  m_feat->reform(f_num, data_num); 
+
+  /*---  read features  ---*/
+  int dx; 
+  for (dx = 0; dx < data_num; ++dx) {
+    if (dx > 0) len = readLine(&file, buff, buff_size); 
+    int line_no = dx + 1; 
+    if (isSparse) {
+      parseDataLine_Sparse(buff, len, f_num, data_fn, 
+                    line_no+1, /* "+1" for the header */
+                    m_feat, dx); 
+    }
+    else {
+      parseDataLine(buff, len, f_num, data_fn, line_no, 
+                    m_feat, dx); 
+    }
+  }
+  file.close(); 
+}
+
+/*------------------------------------------------------------------*/
+/* returns the length without '\n' */
+int AzSvDataS::readLine(AzFile *file, AzByte *buff, int buff_size)
+{
+  int len = file->gets(buff, buff_size); 
+  if (len > 0 && buff[len-1] == '\n') --len; 
+  return MAX(len, 0); 
+}
+
 /*------------------------------------------------------------------*/
 void AzSvDataS::parseDataLine_Sparse(const AzByte *inp, 
                               int inp_len, 
@@ -62,12 +62,22 @@ public:
   virtual void read_targets_only(const char *y_fn); 
   void destroy(); 
 
+  /*---  hand over the features and targets without copying; this is emptied.  ---*/
+  /*---  copy featInfo() before calling this if it is needed.                   ---*/
+  void transfer_to(AzSmat *m_out, 
+                   AzDvect *v_out=NULL) { /* may be NULL */
+    checkIfReady("transfer_to"); 
+    m_out->transfer_from(&m_feat); 
+    if (v_out != NULL) v_out->transfer_from(&v_y); 
+    reset(); 
+  }
+
   /*---  static tools  ---*/
   static void readMatrix(const char *fn, 
                          AzSmat *m_data) {
     AzSvDataS dataset; 
     dataset.read_features_only(fn); 
-    m_data->set(dataset.feat()); 
+    dataset.transfer_to(m_data); 
   }
 
   static void readVector(const char *fn, 
@@ -118,7 +128,13 @@ protected:
                          int expected_f_num, 
                          /*---  output  ---*/
                          AzSmat *m_data) {
-    readData_Small(data_fn, expected_f_num, m_data); 
+    /*---  the whole file is read into memory only if it is under 2GB  ---*/
+    AzFile file(data_fn); 
+    file.open("rb"); 
+    AzInt64 file_size = file.size(); 
+    file.close(); 
+    if (file_size >= AzSigned32Max) readData_Large(data_fn, expected_f_num, m_data); 
+    else                            readData_Small(data_fn, expected_f_num, m_data); 
   }
   static void readData_Small(const char *data_fn, 
                          int expected_f_num, 
@@ -144,6 +160,7 @@ protected:
                          int expected_f_num, 
                          /*---  output  ---*/
                          AzSmat *m_feat); 
+  static int readLine(AzFile *file, AzByte *buff, int buff_size); 
 
   /*---  For the sparse data format  ---*/
   static void parseDataLine_Sparse(const AzByte *inp, 
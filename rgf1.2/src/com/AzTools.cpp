@@ -19,6 +19,21 @@
 
 #include "AzTools.hpp"
 #include "AzPrint.hpp"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/*--------------------------------------------------------*/
+int AzTools::processId()
+{
+#ifdef _WIN32
+  return _getpid(); 
+#else
+  return (int)getpid(); 
+#endif
+}
 
 /*--------------------------------------------------------*/
 int AzTools::writeList(const char *fn, 
@@ -46,10 +61,10 @@ void AzTools::readList(const char *fn,
 {
   AzFile file(fn); 
   file.open("rb"); 
-  int sz = file.size(); 
+  AzInt64 sz = file.size(); 
 
   AzByte *buff = NULL; 
-  int buff_len = sz+1; 
+  int buff_len = (int)MIN(sz+1, (AzInt64)AzSigned32Max); 
   AzBaseArray<AzByte> _a(buff_len, &buff);
 
   for ( ; ; ) {
@@ -320,19 +335,23 @@ void AzTools::shuffleFile(const char *fn,
   AzFile out_file(out_fn); 
   out_file.open("wb"); 
 
-  AzIIarr iia_offs_len; 
+  AzIntArr ia_len; 
   AzFile file(fn); 
   file.open("X"); 
-  int offs = 0; 
   int lx = 0; 
   for ( ; ; ++lx) {
     int len = file.gets(buff, buff_size); 
     if (len <= 0) break; 
-    iia_offs_len.put(offs, len); 
-    offs += len; 
+    ia_len.put(len); 
   }
 
-  int line_num = iia_offs_len.size(); 
+  /*---  64-bit offsets so that the file can be over 2GB  ---*/
+  int line_num = ia_len.size(); 
+  AzInt64 *offs = NULL; 
+  AzBaseArray<AzInt64> _a_offs(line_num+1, &offs); 
+  offs[0] = 0; 
+  for (lx = 0; lx < line_num; ++lx) offs[lx+1] = offs[lx] + ia_len.get(lx); 
+
   AzIntArr ia_lx;   
   ia_lx.range(0, line_num); 
   shuffle(random_seed, &ia_lx); 
@@ -341,10 +360,8 @@ void AzTools::shuffleFile(const char *fn,
   int ix; 
   for (ix = 0; ix < line_num; ++ix) {
     lx = my_lx[ix]; 
-    int offs, len; 
-    iia_offs_len.get(lx, &offs, &len); 
-
-    file.seekReadBytes(offs, len, buff); 
+    int len = ia_len.get(lx); 
+    file.seekReadBytes(offs[lx], len, buff); 
     out_file.writeBytes(buff, len); 
   }
   file.close(); 
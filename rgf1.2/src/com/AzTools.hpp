@@ -97,6 +97,9 @@ public:
                          int random_seed, 
                          const char *out_fn); 
 
+  /*---  for names of temporary files  ---*/
+  static int processId(); 
+
   static inline int big_rand() {
     return (rand() % 32768) * 32768 + (rand() % 32768); 
   }
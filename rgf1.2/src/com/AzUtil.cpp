@@ -16,13 +16,28 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * * * * */
 
+/*---  64-bit file offsets on 32-bit systems; must come before the system headers  ---*/
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include <time.h>
 #include <ctype.h>
 #include "AzUtil.hpp"
 #include "AzPrint.hpp"
+#include "AzSort.hpp"
 
 static int th_autoSqueeze = 1024; 
 
+/*---  seek/tell with 64-bit offsets  ---*/
+#ifdef _MSC_VER
+#define Az_fseek(fp,offs,origin) _fseeki64(fp,offs,origin)
+#define Az_ftell(fp) _ftelli64(fp)
+#else
+#define Az_fseek(fp,offs,origin) fseeko(fp,(off_t)(offs),origin)
+#define Az_ftell(fp) ((AzInt64)ftello(fp))
+#endif
+
 /***************************************************************/
 /***************************************************************/
 /*-------------------------------------------------------------*/
@@ -105,7 +120,7 @@ void AzFile::close(bool doCheckError)
 }
 
 /*-------------------------------------------------------------*/
-int AzFile::size() 
+AzInt64 AzFile::size() 
 {
   const char *eyec = "AzFile::size";
 
@@ -114,20 +129,20 @@ int AzFile::size()
   }
 
   /*-----  keep current offset  -----*/
-  int offs = ftell(fp); 
+  AzInt64 offs = Az_ftell(fp); 
 
   /*-----  seek to eof  -----*/
-  if (fseek(fp, 0, SEEK_END) != 0) {
+  if (Az_fseek(fp, 0, SEEK_END) != 0) {
     throw new AzException(AzFileIOError, eyec, pointFileName(), "seek to end"); 
   }
 
-  int size = ftell(fp); 
-  if (size == -1L) {
+  AzInt64 size = Az_ftell(fp); 
+  if (size == -1) {
     throw new AzException(AzFileIOError, eyec, pointFileName(), "ftell"); 
   }
 
   /*-----  seek it back  -----*/
-  if (fseek(fp, offs, SEEK_SET) != 0) {
+  if (Az_fseek(fp, offs, SEEK_SET) != 0) {
     throw new AzException(AzFileIOError, eyec, pointFileName(), "seek"); 
   }  
 
@@ -135,10 +150,10 @@ int AzFile::size()
 }
 
 /*-------------------------------------------------------------*/
-int AzFile::getOffset() const
+AzInt64 AzFile::getOffset() const
 {
   if (fp == NULL) return -1; 
-  return ftell(fp); 
+  return Az_ftell(fp); 
 }
 
 /*-------------------------------------------------------------*/
@@ -157,12 +172,12 @@ int AzFile::gets(AzByte *buff, int buffsize)
 }
 
 /*-------------------------------------------------------------*/
-void AzFile::seekReadBytes(int offs, int len, void *buff) 
+void AzFile::seekReadBytes(AzInt64 offs, int len, void *buff) 
 {
   const char *eyec = "AzFile::seekRead"; 
   /*-----  seek  -----*/
   if (offs >= 0) {
-    if (fseek(fp, offs, SEEK_SET) != 0) {
+    if (Az_fseek(fp, offs, SEEK_SET) != 0) {
       throw new AzException(AzFileIOError, eyec, pointFileName(), "seek"); 
     }
   }
@@ -176,7 +191,7 @@ void AzFile::seekReadBytes(int offs, int len, void *buff)
 }
 
 /*-------------------------------------------------------------*/
-void AzFile::seek(int offs) 
+void AzFile::seek(AzInt64 offs) 
 {
   seekReadBytes(offs, 0, NULL); 
 }
@@ -239,6 +254,83 @@ int az_compare_IIFarr_FloatInt1Int2_A(const void *v1, const void *v2);
 int az_compare_IIFarr_FloatInt1Int2_D(const void *v1, const void *v2); 
 int az_compare_IIFarr_Int1_A(const void *v1, const void *v2);
 
+/*---  for sorting with AzSort.  The order, including the order of ties,  ---*/
+/*---  is the same as that of a stable sort with the comparators above.   ---*/
+enum AzIIFarrField { 
+  AzIIF_Int1 = 0, 
+  AzIIF_Int2 = 1, 
+  AzIIF_Val = 2, 
+}; 
+class AzIIFarr_Int1Key { public: 
+  inline AzUint64 operator()(const AzIIFarrEnt &e) const { return AzSort::key(e.int1); }
+}; 
+class AzIIFarr_Int2Key { public: 
+  inline AzUint64 operator()(const AzIIFarrEnt &e) const { return AzSort::key(e.int2); }
+}; 
+class AzIIFarr_ValKey { public: 
+  inline AzUint64 operator()(const AzIIFarrEnt &e) const { return AzSort::key(e.val); }
+}; 
+class AzIIFarr_Less { 
+public: 
+  const AzIIFarrField *flds; 
+  int f_num; 
+  bool isAscending; 
+  AzIIFarr_Less(const AzIIFarrField *f, int n, bool asc) : flds(f), f_num(n), isAscending(asc) {}
+  inline bool operator()(const AzIIFarrEnt &e1, const AzIIFarrEnt &e2) const {
+    const AzIIFarrEnt *p1 = &e1, *p2 = &e2; 
+    if (!isAscending) { 
+      p1 = &e2; p2 = &e1; 
+    }
+    int fx; 
+    for (fx = 0; fx < f_num; ++fx) {
+      if (flds[fx] == AzIIF_Int1) {
+        if (p1->int1 != p2->int1) return (p1->int1 < p2->int1); 
+      }
+      else if (flds[fx] == AzIIF_Int2) {
+        if (p1->int2 != p2->int2) return (p1->int2 < p2->int2); 
+      }
+      else {
+        if (p1->val < p2->val) return true; 
+        if (p1->val > p2->val) return false; 
+      }
+    }
+    return false; 
+  }
+}; 
+
+/*-------------------------------------------------------------*/
+/* stable; flds: most significant first */
+static void az_sort_IIFarr(AzIIFarrEnt *ent, int ent_num, 
+                           const AzIIFarrField *flds, int f_num, 
+                           bool isAscending)
+{
+  if (ent_num <= 1) return; 
+  if (ent_num < AzSort::small_num) {
+    AzSort::insertion(ent, ent_num, AzIIFarr_Less(flds, f_num, isAscending)); 
+    return; 
+  }
+  AzIIFarrEnt *work = NULL; 
+  AzBaseArray<AzIIFarrEnt> a_work; 
+  a_work.alloc(&work, ent_num, "az_sort_IIFarr", "work"); 
+  int fx; 
+  for (fx = f_num-1; fx >= 0; --fx) { /* least significant first */
+    if (flds[fx] == AzIIF_Int1) {
+      AzSort::radix(ent, ent_num, AzIIFarr_Int1Key(), 32, isAscending, work); 
+    }
+    else if (flds[fx] == AzIIF_Int2) {
+      AzSort::radix(ent, ent_num, AzIIFarr_Int2Key(), 32, isAscending, work); 
+    }
+    else {
+      AzSort::radix(ent, ent_num, AzIIFarr_ValKey(), 64, isAscending, work); 
+    }
+  }
+}
+static const AzIIFarrField az_IIF_IntInt[] = { AzIIF_Int1, AzIIF_Int2 }; 
+static const AzIIFarrField az_IIF_Int2Int1[] = { AzIIF_Int2, AzIIF_Int1 }; 
+static const AzIIFarrField az_IIF_Float[] = { AzIIF_Val }; 
+static const AzIIFarrField az_IIF_FloatInt1Int2[] = { AzIIF_Val, AzIIF_Int1, AzIIF_Int2 }; 
+static const AzIIFarrField az_IIF_Int1[] = { AzIIF_Int1 }; 
+
 /*------------------------------------------------------------------*/
 int AzIIFarr::bsearch_Float(double key, bool isAscending) const
 {
@@ -356,11 +448,7 @@ void AzIIFarr::concat(const AzIIFarr *iifq2)
   }
 
   int new_num = ent_num + iifq2->ent_num; 
-  int ent_num_max = a.size(); 
-  if (new_num > ent_num_max) {
-    ent_num_max = new_num; 
-    a.realloc(&ent, ent_num_max, eyec, "ent realloc"); 
-  }
+  a.reserve(&ent, new_num, eyec, "ent realloc"); 
 
   memcpy(ent + ent_num, iifq2->ent, sizeof(ent[0]) * iifq2->ent_num);  
   ent_num = new_num; 
@@ -387,11 +475,7 @@ void AzIIFarr::concat(const AzIIFarr *iifq2, double req_val)
   }
 
   int new_num = ent_num + iifq2->ent_num; 
-  int ent_num_max = a.size(); 
-  if (new_num > ent_num_max) {
-    ent_num_max = new_num; 
-    a.realloc(&ent, ent_num_max, eyec, "ent realloc"); 
-  }
+  a.reserve(&ent, new_num, eyec, "ent realloc"); 
   int ix; 
   for (ix = 0; ix < iifq2->ent_num; ++ix) {
     if (iifq2->ent[ix].val == req_val) {
@@ -509,16 +593,8 @@ void AzIIFarr::put(int int1, int int2, double val)
 {
   const char *eyec = "AzIIFarr::put";
 
-  int ent_num_max = a.size(); 
-  if (ent_num >= ent_num_max) {
-    if (ent_num_max <= 0) 
-      ent_num_max = 32; 
-    else if (ent_num_max < 1024) 
-      ent_num_max *= 2; 
-    else
-      ent_num_max += 1024; 
-
-    a.realloc(&ent, ent_num_max, eyec, "2"); 
+  if (ent_num >= a.size()) {
+    a.reserve(&ent, ent_num+1, eyec, "2"); 
   }
   ent[ent_num].int1 = int1; 
   ent[ent_num].int2 = int2; 
@@ -595,7 +671,7 @@ void AzIIFarr::squeeze_Sum()
     return; 
   }
 
-  qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_IntInt_A); 
+  az_sort_IIFarr(ent, ent_num, az_IIF_IntInt, 2, true); 
 
   int ex1 = 0; 
   int ex; 
@@ -622,7 +698,7 @@ void AzIIFarr::squeeze_Max()
     return; 
   }
 
-  qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_IntInt_A); 
+  az_sort_IIFarr(ent, ent_num, az_IIF_IntInt, 2, true); 
 
   int ex1 = 0; 
   int ex; 
@@ -649,7 +725,7 @@ void AzIIFarr::squeeze_Int1_Max()
     return; 
   }
 
-  qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Int1_A); 
+  az_sort_IIFarr(ent, ent_num, az_IIF_Int1, 1, true); 
 
   int ex1 = 0; 
   int ex; 
@@ -677,7 +753,7 @@ void AzIIFarr::squeeze_Int1_Sum()
     return; 
   }
 
-  qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Int1_A); 
+  az_sort_IIFarr(ent, ent_num, az_IIF_Int1, 1, true); 
 
   int ex1 = 0; 
   int ex; 
@@ -706,12 +782,7 @@ void AzIIFarr::sort_IntInt(bool isAscending)
     return; 
   }
 
-  if (isAscending) {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_IntInt_A); 
-  }
-  else {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_IntInt_D); 
-  }
+  az_sort_IIFarr(ent, ent_num, az_IIF_IntInt, 2, isAscending); 
 }
 
 /*-------------------------------------------------------------*/
@@ -721,12 +792,7 @@ void AzIIFarr::sort_Int2Int1(bool isAscending)
     return; 
   }
 
-  if (isAscending) {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Int2Int1_A); 
-  }
-  else {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Int2Int1_D); 
-  }
+  az_sort_IIFarr(ent, ent_num, az_IIF_Int2Int1, 2, isAscending); 
 }
 
 /*-------------------------------------------------------------*/
@@ -736,12 +802,7 @@ void AzIIFarr::sort_Float(bool isAscending)
     return; 
   }
 
-  if (isAscending) {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Float_A); 
-  }
-  else {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_Float_D); 
-  }
+  az_sort_IIFarr(ent, ent_num, az_IIF_Float, 1, isAscending); 
 }
 
 /*-------------------------------------------------------------*/
@@ -751,12 +812,7 @@ void AzIIFarr::sort_FloatInt1Int2(bool isAscending)
     return; 
   }
 
-  if (isAscending) {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_FloatInt1Int2_A); 
-  }
-  else {
-    qsort(ent, ent_num, sizeof(ent[0]), az_compare_IIFarr_FloatInt1Int2_D); 
-  }
+  az_sort_IIFarr(ent, ent_num, az_IIF_FloatInt1Int2, 3, isAscending); 
 }
 
 /*-------------------------------------------------------------*/
@@ -1117,6 +1173,17 @@ void AzIntArr::reset(int num, int initial_value)
   initialize(num, initial_value); 
 }
 
+/*------------------------------------------------------------------*/
+/* For callers that write every slot; keeps the buffer if it's big enough */
+void AzIntArr::reset_noinit(int new_num) 
+{
+  if (a.size() < new_num) {
+    a.free(&ints); 
+    a.alloc(&ints, new_num, "AzIntArr::reset_noinit", "ints"); 
+  }
+  num = MAX(new_num, 0); 
+}
+
 /*------------------------------------------------------------------*/
 void AzIntArr::fill(int num, int first_value)
 {
@@ -1143,7 +1210,7 @@ void AzIntArr::unique()
     return; 
   }
 
-  qsort(ints, num, sizeof(ints[0]), az_compareInt_A);   
+  AzSort::sort_int(ints, num, true); 
 
   int ix1 = 0; 
   int ix; 
@@ -1173,18 +1240,7 @@ void AzIntArr::increment(int index)
 /*------------------------------------------------------------------*/
 void AzIntArr::_realloc()
 {
-  int num_max = a.size(); 
-  if (num_max <= 0) {
-    num_max = 32; 
-  }
-  else if (num_max < 1024 * 1024) {
-    num_max *= 2; 
-  }
-  else {
-    num_max += 1024 * 1024; 
-  }
-
-  a.realloc(&ints, num_max, "AzIntArr::_realloc", "ints"); 
+  a.reserve(&ints, num+1, "AzIntArr::_realloc", "ints"); 
 }
 
 /*------------------------------------------------------------------*/
@@ -1200,17 +1256,12 @@ void AzIntArr::concat(const int *ints2, int ints2_num)
     return; 
   }
 
-  int new_num = num + ints2_num; 
-  int num_max = a.size(); 
-  if (new_num > num_max) {
-    num_max = (new_num+1023)/1024*1024; 
-    a.realloc(&ints, num_max, "AzIntArr::concat", "ints"); 
-  }
-
-  int ix; 
-  for (ix = 0; ix < ints2_num; ++ix) {
-    ints[num + ix] = ints2[ix]; 
+  if ((AzInt64)num + ints2_num > 0x7fffffff) {
+    throw new AzException(AzAllocError, "AzIntArr::concat", "too many ints"); 
   }
+  int new_num = num + ints2_num; 
+  a.reserve(&ints, new_num, "AzIntArr::concat", "ints"); 
+  memcpy(ints + num, ints2, sizeof(ints[0])*ints2_num); 
   num = new_num; 
 }
 
@@ -1264,12 +1315,7 @@ void AzIntArr::sort(bool ascending)
     return; 
   }
 
-  if (ascending) {
-    qsort(ints, num, sizeof(ints[0]), az_compareInt_A); 
-  }
-  else {
-    qsort(ints, num, sizeof(ints[0]), az_compareInt_D); 
-  }
+  AzSort::sort_int(ints, num, ascending); 
 }
 
 /*------------------------------------------------------------------*/
@@ -36,6 +36,8 @@ using namespace std;
 #include "AzOut.hpp"
 
 typedef unsigned char AzByte; 
+typedef long long AzInt64;
+typedef unsigned long long AzUint64; 
 
 /*---  binary files are written in little-endian  ---*/
 #define AzBigEndian_isSwapNeeded    true
@@ -138,11 +140,11 @@ public:
   int writeBytes(const void *buff, int len); 
 
   int gets(AzByte *buff, int buffsize); 
-  void seekReadBytes(int offs, int len, void *buff); 
-  void seek(int offs); 
+  void seekReadBytes(AzInt64 offs, int len, void *buff); /* offs<0: current position */
+  void seek(AzInt64 offs); 
 
-  int getOffset() const; 
-  int size(); 
+  AzInt64 getOffset() const; 
+  AzInt64 size(); 
 
   const char *pointFileName() const; 
    
@@ -219,6 +221,14 @@ public:
     _swap((AzByte *)x, 2,5); 
     _swap((AzByte *)x, 3,4); 
   }
+  inline static void swap_float(float *x) {
+    if (!isSwapNeeded) return; 
+    _swap((AzByte *)x, 0,3); 
+    _swap((AzByte *)x, 1,2); 
+  }
+  /*---  for AZ_MTX_FLOAT, which may be either  ---*/
+  inline static void swap_val(double *x) { swap_double(x); }
+  inline static void swap_val(float *x) { swap_float(x); }
 protected:
   inline static void _swap(AzByte *x, int p, int q) {
     AzByte _b = *(x+p); 
@@ -305,6 +315,7 @@ public:
   }
   inline void reset_norelease() { num = 0; }
   void reset(int num, int initial_value); 
+  void reset_noinit(int num); /* the values are undefined */
   inline void reset(const AzIntArr *inp) {
     reset(); 
     concat(inp); 
@@ -350,6 +361,7 @@ public:
   }
 
   inline int size() const { return num; }
+  inline AzInt64 memSize() const { return (AzInt64)a.size()*sizeof(int); }
 
   void sort(bool ascending); 
   void prepare(int prep_num); 
@@ -426,6 +438,7 @@ typedef struct {
   int int1, int2; 
   double val; 
 } AzIIFarrEnt; 
+AzDeclarePod(AzIIFarrEnt)
 
 enum AzIIFarrType {
   AzIIFarr_IIF = 0, AzIIFarr_II = 1, AzIIFarr_IF = 2
@@ -513,6 +526,13 @@ public:
     _read(file); 
   }
 
+  /*---  take over the contents of inp without copying; inp becomes empty  ---*/
+  void transfer_from(AzIIFarr *inp) {
+    a.transfer_from(&inp->a, &ent, &inp->ent, "AzIIFarr::transfer_from"); 
+    ent_num = inp->ent_num; inp->ent_num = 0; 
+    ent_type = inp->ent_type; 
+  }
+
   inline AzIIFarrType get_ent_type() { return ent_type; }
 
 protected:
@@ -555,6 +575,7 @@ public:
     iifq.reset(num, int1, int2, 0); 
   }
   void prepare(int num) { iifq.prepare(num); }
+  void transfer_from(AzIIarr *inp) { iifq.transfer_from(&inp->iifq); }
   void cut(int new_num) { iifq.cut(new_num); }
   inline int size() const { return iifq.size(); }
   void put(int int1, int int2) { iifq.put(int1, int2, 0); }
@@ -606,6 +627,7 @@ public:
   }
   inline void reset() { iifq.reset(); }
   inline void prepare(int num) { iifq.prepare(num); }
+  inline void transfer_from(AzIFarr *inp) { iifq.transfer_from(&inp->iifq); }
   inline void reset(int num, int int1, double val) { 
     iifq.reset(num, int1, AzNone, val); 
   }
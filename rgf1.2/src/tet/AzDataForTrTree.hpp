@@ -25,9 +25,12 @@
 #include "AzSortedFeat.hpp"
 #include "AzParam.hpp"
 #include "AzHelp.hpp"
+#include "AzTools.hpp"
 
 #define kw_dataproc  "data_management="
 #define help_dataproc "Sparse|Dense|Auto.  Data is treated either as \"Sparse\" data (having many zeroes), as \"Dense\" data, or as \"Auto\"matically determined.  It affects speed and memory consumption of training."
+#define kw_presort_cache "presort_cache="
+#define help_presort_cache "Path prefix of the cache of pre-sorted training data.  If the cache for the same training data exists, it is read instead of sorting the data; otherwise, it is created.  The file name is this prefix followed by a fingerprint of the data."
 
 /*--------------------------------------------------------*/
 class AzDataForTrTree {
@@ -35,12 +38,11 @@ protected:
   int data_num; 
   AzSmat m_tran_sparse; 
   /*-------------------------*/
-  AzDmat m_tran_dense;  
+  AzFmat m_tran_dense;  
   /*
-   *  After construction, this matrix is locked so that any operation that 
-   *  would change the pointers to column vectors is prohibited, as a safety 
-   *  measure, as AzSortedFeatDense keeps those pointers.  
-   *  Faster than safer design through abstraction.  
+   *  AzSortedFeatDense keeps pointers to the column vectors of this matrix, 
+   *  so it must not be reset while the sorted arrays are in use.  
+   *  Values are stored in AZ_MTX_FLOAT.  
    */
   /*-------------------------*/
 
@@ -57,11 +59,12 @@ protected:
   #define Az_max_test_entries (1024*1024*16)
   dataproc_Type dataproc; 
   AzBytArr s_dataproc; 
+  AzBytArr s_presort_cache; 
 
 public:
   AzDataForTrTree() : dataproc(dataproc_Auto), data_num(0) {}
   virtual void reset_data(const AzOut &out, 
-                  const AzSmat *m_data, 
+                  AzSmat *m_data, /* destroyed while being transposed */
                   AzParam &p, 
                   bool beTight, 
                   const AzSvFeatInfo *inp_feat=NULL)
@@ -93,34 +96,61 @@ public:
 
    /*---  pre-sort data  ---*/
     m_tran_sparse.reset(); 
-    m_tran_dense.unlock(); 
     m_tran_dense.reset(); 
     data_num = m_data->colNum(); 
-    if (doSparse) {
-      m_data->transpose(&m_tran_sparse); 
-      sorted_arr.reset_sparse(&m_tran_sparse, beTight); 
+    int f_num = m_data->rowNum(); 
+    AzBytArr s_cache_fn; 
+    if (s_presort_cache.length() > 0) {
+      genCacheFn(m_data, doSparse, &s_cache_fn); 
+    }
+    bool isRead = false; 
+    if (s_cache_fn.length() > 0 && AzFile::isExisting(s_cache_fn.c_str())) {
+      AzPrint::writeln(out, "Reading pre-sorted data: ", s_cache_fn.c_str()); 
+      try {
+        readPresorted(s_cache_fn.c_str(), m_data, doSparse, beTight); 
+        isRead = true; 
+      }
+      catch (AzException *e) {
+        /*---  broken or doesn't match; sort the data again  ---*/
+        AzPrint::writeln(out, "Unusable pre-sorted data: ", e->getMessage().c_str()); 
+        delete e; 
+        m_tran_sparse.reset(); 
+        m_tran_dense.reset(); 
+      }
+    }
+    if (isRead) {
+      m_data->reset(); 
     }
     else {
-      m_tran_dense.transpose_from(m_data); 
-      sorted_arr.reset_dense(&m_tran_dense, beTight); 
-      /* prohibit any action to change the pointers to the column vectors */
-      m_tran_dense.lock(); 
+      /*---  transpose directly into the final form, releasing the input  ---*/
+      if (doSparse) {
+        m_data->transpose_destroy(&m_tran_sparse); 
+        sorted_arr.reset_sparse(&m_tran_sparse, beTight); 
+      }
+      else {
+        m_tran_dense.transpose_from_destroy(m_data); 
+        sorted_arr.reset_dense(&m_tran_dense, beTight); 
+      }
+      if (s_cache_fn.length() > 0) {
+        AzPrint::writeln(out, "Writing pre-sorted data: ", s_cache_fn.c_str()); 
+        writePresorted(s_cache_fn.c_str(), doSparse); 
+      }
     }
     if (inp_feat != NULL) {
       feat.reset(inp_feat); 
-      if (feat.featNum() != m_data->rowNum()) {
+      if (feat.featNum() != f_num) {
         throw new AzException(AzInputError, "AzDataForTrTree::reset", "#feat mismatch"); 
       }
     }
     else {
-      feat.reset(m_data->rowNum()); 
+      feat.reset(f_num); 
     }
   }
 
   virtual void reset_data_for_test(const AzOut &out, 
                      const AzSmat *m_data) {
     bool doSparse = false; 
-    if (m_data->rowNum()*m_data->colNum() > Az_max_test_entries) { /* large data */
+    if ((AzInt64)m_data->rowNum()*(AzInt64)m_data->colNum() > Az_max_test_entries) { /* large data */
       /*---  dense is faster but uses up more memory if data is sparse  ---*/
       double nz_ratio; 
       m_data->nonZeroNum(&nz_ratio); 
@@ -171,6 +201,15 @@ public:
     return &feat; 
   }
 
+  /*---  bytes of the transposed data and its sorted arrays  ---*/
+  AzInt64 memSize() const {
+    return m_tran_sparse.memSize() + m_tran_dense.memSize() + sorted_arr.memSize(); 
+  }
+  /*---  Conservative from here on; before any tree is made  ---*/
+  void tighten() {
+    sorted_arr.tighten(); 
+  }
+
   virtual inline const AzSortedFeatArr *sorted_array() const {
     return &sorted_arr; 
   }
@@ -182,12 +221,104 @@ public:
   virtual void printHelp(AzHelp &h) const {
     h.begin("", "AzDataForTrTree", "Data processing"); 
     h.item(kw_dataproc, help_dataproc, "Auto"); 
+    h.item_experimental(kw_presort_cache, help_presort_cache); 
   }
 
 protected: 
+  /*---  cache of pre-sorted data  ---*/
+  /* 64-bit FNV-1a over the data contents and the data type */
+  void genCacheFn(const AzSmat *m_data, bool doSparse, 
+                  AzBytArr *s_fn) const {
+    AzByte flag = (doSparse) ? 1 : 0; 
+    AzByte float_size = (AzByte)sizeof(AZ_MTX_FLOAT); /* the cache holds AZ_MTX_FLOAT */
+    AzUint64 h = 14695981039346656037ULL; 
+    h = fnv1a(h, &flag, sizeof(flag)); 
+    h = fnv1a(h, &float_size, sizeof(float_size)); 
+    int row_num = m_data->rowNum(), col_num = m_data->colNum(); 
+    h = fnv1a(h, &row_num, sizeof(row_num)); 
+    h = fnv1a(h, &col_num, sizeof(col_num)); 
+    int col; 
+    for (col = 0; col < col_num; ++col) {
+      const AzSvect *v = m_data->col(col); 
+      AzCursor cur; 
+      for ( ; ; ) {
+        double val; 
+        int row = v->next(cur, val); 
+        if (row < 0) break; 
+        h = fnv1a(h, &row, sizeof(row)); 
+        h = fnv1a(h, &val, sizeof(val)); 
+      }
+      h = fnv1a(h, &col, sizeof(col)); /* column boundary */
+    }
+    char hex[32]; 
+    sprintf(hex, "%016llx", h); 
+    s_fn->reset(&s_presort_cache); 
+    s_fn->c(hex); 
+  }
+  static AzUint64 fnv1a(AzUint64 h, const void *ptr, int len) {
+    const AzByte *bytes = (const AzByte *)ptr; 
+    int ix; 
+    for (ix = 0; ix < len; ++ix) {
+      h ^= bytes[ix]; 
+      h *= 1099511628211ULL; 
+    }
+    return h; 
+  }
+
+  void writePresorted(const char *fn, bool doSparse) {
+    /*---  write to a temporary file of this process first so that nobody  ---*/
+    /*---  reads a partial file, and replace the cache file in one step    ---*/
+    AzBytArr s_tmp_fn(fn); 
+    s_tmp_fn.c(".tmp"); 
+    s_tmp_fn.cn(AzTools::processId()); 
+    AzFile file(s_tmp_fn.c_str()); 
+    file.open("wb"); 
+    file.writeBinMarker(); 
+    file.writeBool(doSparse); 
+    if (doSparse) m_tran_sparse.write(&file); 
+    else          m_tran_dense.write(&file); 
+    sorted_arr.write(&file); 
+    file.close(true); 
+#ifdef _WIN32
+    remove(fn); /* rename doesn't replace an existing file here */
+#endif
+    if (rename(s_tmp_fn.c_str(), fn) != 0) {
+      remove(s_tmp_fn.c_str()); 
+      throw new AzException(AzFileIOError, "AzDataForTrTree::writePresorted", 
+                            "Failed to rename to", fn); 
+    }
+  }
+
+  void readPresorted(const char *fn, const AzSmat *m_data, 
+                     bool doSparse, bool beTight) {
+    const char *eyec = "AzDataForTrTree::readPresorted"; 
+    AzFile file(fn); 
+    file.open("rb"); 
+    file.checkBinMarker(); 
+    bool isSparse = file.readBool(); 
+    if (isSparse != doSparse) {
+      throw new AzException(AzInputError, eyec, "data type mismatch", fn); 
+    }
+    if (doSparse) {
+      m_tran_sparse.read(&file); 
+      sorted_arr.read_sparse(&m_tran_sparse, &file, beTight); 
+    }
+    else {
+      m_tran_dense.read(&file); 
+      sorted_arr.read_dense(&m_tran_dense, &file, beTight); 
+    }
+    file.close(); 
+    int row_num = (doSparse) ? m_tran_sparse.rowNum() : m_tran_dense.rowNum(); 
+    int col_num = (doSparse) ? m_tran_sparse.colNum() : m_tran_dense.colNum(); 
+    if (row_num != m_data->colNum() || col_num != m_data->rowNum()) {
+      throw new AzException(AzInputError, eyec, "dimensionality mismatch", fn); 
+    }
+  }
+
   /*---  for parameters  ---*/
   virtual void resetParam(AzParam &p) {
     p.vStr(kw_dataproc, &s_dataproc); 
+    p.vStr(kw_presort_cache, &s_presort_cache); 
     dataproc = dataproc_Auto; 
     if (s_dataproc.length() <= 0 || 
         s_dataproc.compare("Auto") == 0); 
@@ -201,11 +332,24 @@ protected:
   virtual void printParam(const AzOut &out) const {
     if (out.isNull()) return; 
     AzPrint o(out); 
-    if (s_dataproc.length() > 0) {
+    if (s_dataproc.length() > 0 || s_presort_cache.length() > 0) {
       o.ppBegin("AzDataForTrTree", "Data processing"); 
-      o.printV(kw_dataproc, s_dataproc); 
+      o.printV_if_not_empty(kw_dataproc, s_dataproc); 
+      o.printV_if_not_empty(kw_presort_cache, s_presort_cache); 
       o.ppEnd(); 
     }
   }
 };  
+/*---  one data point as seen by AzTreePacked::apply  ---*/
+class AzDataForTrTree_Point {
+protected:
+  const AzDataForTrTree *data; 
+  int dx; 
+public:
+  AzDataForTrTree_Point(const AzDataForTrTree *inp_data, int inp_dx) 
+    : data(inp_data), dx(inp_dx) {}
+  inline bool isLE(int fx, double border_val) const {
+    return data->isLE(dx, fx, border_val); 
+  }
+}; 
 #endif 
@@ -94,6 +94,11 @@ protected:
             const AzSortedFeat *sorted, 
             int dxs_num, 
             const Az_forFindSplit *total); 
+  void loop_q(AzTrTsplit *best_split, /* using 16-bit targets */
+            int fx, /* feature# */
+            const AzSortedFeat *sorted, 
+            int dxs_num, 
+            const AzInt64 q_total[2]); 
 }; 
 
 #endif 
@@ -120,6 +120,21 @@ void AzOptOnTree::copy_from(const AzOptOnTree *inp)
   doIntercept = inp->doIntercept; 
   doUnregIntercept = inp->doUnregIntercept; 
   doUseAvg = inp->doUseAvg; 
+  doOptByTree = inp->doOptByTree; 
+  a_leaf_ids.free(&leaf_ids); 
+  block_newton = inp->block_newton; 
+  doOptLBFGS = inp->doOptLBFGS; 
+  lbfgs_mem = inp->lbfgs_mem; 
+  lbfgs.reset(); 
+  doOptParallel = inp->doOptParallel; 
+  shotgun_num = inp->shotgun_num; 
+  active_full = inp->active_full; 
+  active_stall = inp->active_stall; 
+  active_count = inp->active_count; 
+  doFullNext = inp->doFullNext; 
+  isPartial = inp->isPartial; 
+  doActiveSet = false; 
+  ia_active_fx.reset(); 
 
   ens = NULL; 
   tree_feat = NULL; 
@@ -171,6 +186,7 @@ void AzOptOnTree::iterate(int inp_ite_num,
   if (ite_num <= 0) {
     return; 
   }
+  if (doOptLBFGS) lbfgs.forget(); /* the features or the predictions may have changed */
 
   double nn; 
   if (AzDvect::isNull(&v_fixed_dw)) nn = v_y.rowNum(); 
@@ -323,28 +339,687 @@ void AzOptOnTree::_update_with_features_TempFile(
   int tx; 
   for (tx = 0; tx < tree_num; ++tx) {
     ens->tree_u(tx)->restoreDataIndexes(); 
+    if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); /* read ahead while tx is processed */
     AzIIarr iia_nx_fx; 
     tree_feat->featIds(tx, &iia_nx_fx); 
-    int num = iia_nx_fx.size(); 
-    int ix; 
-    for (ix = 0; ix < num; ++ix) {
-      int nx, fx; 
-      iia_nx_fx.get(ix, &nx, &fx); 
-      if (tree_feat->featInfo(fx)->isRemoved) continue; /* shouldn't happen though */
+    update_features_of_tree(&iia_nx_fx, nlam, nsig, py_avg, for_del); 
+    ens->tree_u(tx)->releaseDataIndexes(); 
+  }
+}
 
-      double w = v_w.get(fx); 
+/*--------------------------------------------------------*/
+void AzOptOnTree::update_features_of_tree(
+                      const AzIIarr *iia_nx_fx, 
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  int num = iia_nx_fx->size(); 
+  int ix; 
+  for (ix = 0; ix < num; ++ix) {
+    int nx, fx; 
+    iia_nx_fx->get(ix, &nx, &fx); 
+    if (tree_feat->featInfo(fx)->isRemoved) continue; /* shouldn't happen though */
+
+    double w = v_w.get(fx); 
+    int dxs_num; 
+    const int *dxs = data_points(fx, &dxs_num); 
+    double my_nlam = reg_depth->apply(nlam, node(fx)->depth); 
+    double my_nsig = reg_depth->apply(nsig, node(fx)->depth); 
+    double delta = getDelta(dxs, dxs_num, w, my_nlam, my_nsig, py_avg, for_del); 
+    v_w.set(fx, w+delta); 
+    updatePred(dxs, dxs_num, delta, &v_p); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* Leaves of a tree don't share data points, so their weights can be   */
+/* updated together: one pass over the leaf ids to sum the derivatives */
+/* of all the leaves, and another to add the changes to the prediction.*/
+/* Trees with features on internal nodes are done feature by feature.  */
+/*--------------------------------------------------------*/
+void AzOptOnTree::_update_with_features_ByTree(
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size();
+  if (a_leaf_ids.size() < tree_num) {
+    a_leaf_ids.realloc(&leaf_ids, tree_num, "AzOptOnTree::_update_with_features_ByTree"); 
+  }
+  int tx; 
+  for (tx = 0; tx < tree_num; ++tx) {
+    AzIIarr iia_nx_fx; 
+    tree_feat->featIds(tx, &iia_nx_fx); 
+    if (leaf_ids[tx] == NULL) leaf_ids[tx] = new AzOptOnTree_LeafIds(); 
+    AzOptOnTree_LeafIds *lid = leaf_ids[tx]; 
+    bool doRebuild = (!lid->isSame(&iia_nx_fx) || lid->dataNum() != v_p.rowNum()); 
+    if (doRebuild || !lid->usable()) {
+      if (doTemp) {
+        ens->tree_u(tx)->restoreDataIndexes(); 
+        if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); 
+      }
+      if (doRebuild) resetLeafIds(&iia_nx_fx, lid); 
+      if (!lid->usable()) {
+        update_features_of_tree(&iia_nx_fx, nlam, nsig, py_avg, for_del); 
+      }
+      if (doTemp) ens->tree_u(tx)->releaseDataIndexes(); 
+      if (!lid->usable()) continue; 
+    }
+    update_leaves_of_tree(lid, nlam, nsig, py_avg, for_del); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* Features on the leaves of a tree don't share data points, so the    */
+/* leaves are updated in parallel: with shotgun_num=1 this is the same */
+/* as the sequential update.  With shotgun_num>1, the leaves of that   */
+/* many trees are all computed from the same predictions.  Trees with  */
+/* features on internal nodes are done feature by feature.             */
+/*--------------------------------------------------------*/
+void AzOptOnTree::_update_with_features_Parallel(
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size();
+  int tx0; 
+  for (tx0 = 0; tx0 < tree_num; tx0 += shotgun_num) {
+    int tx1 = MIN(tree_num, tx0+shotgun_num); 
+    AzIntArr ia_fx, ia_fx_begin; /* leaf features of the trees; where each tree begins */
+    int tx; 
+    if (doTemp) {
+      /*---  read the next group ahead while this group is processed  ---*/
+      for (tx = tx1; tx < MIN(tree_num, tx1+shotgun_num); ++tx) ens->tree_u(tx)->prefetchDataIndexes(); 
+    }
+    for (tx = tx0; tx < tx1; ++tx) {
+      if (doTemp) ens->tree_u(tx)->restoreDataIndexes(); 
+      AzIntArr ia_tree_fx; 
+      if (leafFeatIds(tx, &ia_tree_fx)) {
+        ia_fx_begin.put(ia_fx.size()); 
+        ia_fx.concat(&ia_tree_fx); 
+      }
+      else {
+        AzIIarr iia_nx_fx; 
+        tree_feat->featIds(tx, &iia_nx_fx); 
+        update_features_of_tree(&iia_nx_fx, nlam, nsig, py_avg, for_del); 
+      }
+    }
+    update_features_par(&ia_fx, &ia_fx_begin, nlam, nsig, py_avg, for_del); 
+    if (doTemp) {
+      for (tx = tx0; tx < tx1; ++tx) ens->tree_u(tx)->releaseDataIndexes(); 
+    }
+  }
+}
+
+/*--------------------------------------------------------*/
+/* Active set: features are grouped by tree (as they are added tree by */
+/* tree) so that the data indexes of a tree are restored only once.    */
+/*--------------------------------------------------------*/
+void AzOptOnTree::_update_with_features_Active(
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  bool doTemp = ens->usingTempFile(); 
+  int num = ia_active_fx.size(); 
+  const int *fxs = ia_active_fx.point(); 
+  int ix0, ix1; 
+  for (ix0 = 0; ix0 < num; ix0 = ix1) {
+    int tx = tree_feat->featInfo(fxs[ix0])->tx; 
+    bool isLeafOnly = true; 
+    for (ix1 = ix0; ix1 < num; ++ix1) {
+      if (tree_feat->featInfo(fxs[ix1])->tx != tx) break; 
+      if (!node(fxs[ix1])->isLeaf()) isLeafOnly = false; 
+    }
+    if (doTemp) {
+      ens->tree_u(tx)->restoreDataIndexes(); 
+      if (ix1 < num) ens->tree_u(tree_feat->featInfo(fxs[ix1])->tx)->prefetchDataIndexes(); 
+    }
+    if (doOptParallel && isLeafOnly) {
+      AzIntArr ia_fx(fxs+ix0, ix1-ix0), ia_fx_begin; 
+      ia_fx_begin.put(0); 
+      update_features_par(&ia_fx, &ia_fx_begin, nlam, nsig, py_avg, for_del); 
+    }
+    else {
+      int ix; 
+      for (ix = ix0; ix < ix1; ++ix) {
+        update_feature(fxs[ix], nlam, nsig, py_avg, for_del); 
+      }
+    }
+    if (doTemp) ens->tree_u(tx)->releaseDataIndexes(); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* true if all the features of the tree are on leaves */
+bool AzOptOnTree::leafFeatIds(int tx, 
+                              AzIntArr *ia_fx) /* output */
+const 
+{
+  AzIIarr iia_nx_fx; 
+  tree_feat->featIds(tx, &iia_nx_fx); 
+  bool isLeafOnly = true; 
+  int num = iia_nx_fx.size(); 
+  int ix; 
+  for (ix = 0; ix < num; ++ix) {
+    int nx, fx; 
+    iia_nx_fx.get(ix, &nx, &fx); 
+    if (tree_feat->featInfo(fx)->isRemoved) continue; 
+    ia_fx->put(fx); 
+    if (!node(fx)->isLeaf()) isLeafOnly = false; 
+  }
+  return isLeafOnly; 
+}
+
+/*--------------------------------------------------------*/
+void AzOptOnTree::update_features_par(
+                      const AzIntArr *ia_fx, 
+                      const AzIntArr *ia_fx_begin, /* where each tree begins */
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  const char *eyec = "AzOptOnTree::update_features_par"; 
+  int num = ia_fx->size(); 
+  if (num <= 0) return; 
+  const int *fxs = ia_fx->point(); 
+  AzDvect v_delta(num); 
+  double *delta = v_delta.point_u(); 
+  AzRgf_forDelta *fd = NULL; 
+  AzBaseArray<AzRgf_forDelta> a_fd; 
+  a_fd.alloc(&fd, num, eyec, "for_delta"); 
+
+  int ix; 
+  AzException *err = NULL; 
+#pragma omp parallel for schedule(dynamic)
+  for (ix = 0; ix < num; ++ix) {
+    try {
+      int fx = fxs[ix]; 
       int dxs_num; 
       const int *dxs = data_points(fx, &dxs_num); 
       double my_nlam = reg_depth->apply(nlam, node(fx)->depth); 
       double my_nsig = reg_depth->apply(nsig, node(fx)->depth); 
-      double delta = getDelta(dxs, dxs_num, w, my_nlam, my_nsig, py_avg, for_del); 
+      delta[ix] = getDelta(dxs, dxs_num, v_w.get(fx), my_nlam, my_nsig, py_avg, &fd[ix]); 
+    }
+    catch (AzException *e) {
+      AzException::keepFirst(e, &err); 
+    }
+  }
+  if (err != NULL) throw err; 
+
+  /*---  in the order of features so that the result is deterministic  ---*/
+  for (ix = 0; ix < num; ++ix) {
+    for_del->merge(&fd[ix]); 
+    v_w.set(fxs[ix], v_w.get(fxs[ix])+delta[ix]); 
+  }
+
+  /*---  leaves of different trees may share data points  ---*/
+  int tree_num = ia_fx_begin->size(); 
+  int tx; 
+  for (tx = 0; tx < tree_num; ++tx) {
+    int ix0 = ia_fx_begin->get(tx); 
+    int ix1 = (tx+1 < tree_num) ? ia_fx_begin->get(tx+1) : num; 
+#pragma omp parallel for schedule(dynamic)
+    for (ix = ix0; ix < ix1; ++ix) {
+      if (delta[ix] == 0) continue; 
+      try {
+        int dxs_num; 
+        const int *dxs = data_points(fxs[ix], &dxs_num); 
+        updatePred(dxs, dxs_num, delta[ix], &v_p); 
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzOptOnTree::resetLeafIds(const AzIIarr *iia_nx_fx, 
+                               AzOptOnTree_LeafIds *lid) /* output */
+const 
+{
+  lid->begin(v_p.rowNum()); 
+  int num = iia_nx_fx->size(); 
+  int ix; 
+  for (ix = 0; ix < num; ++ix) {
+    int nx, fx; 
+    iia_nx_fx->get(ix, &nx, &fx); 
+    const int *dxs = NULL; 
+    int dxs_num = 0; 
+    if (!tree_feat->featInfo(fx)->isRemoved && node(fx)->isLeaf()) {
+      dxs = data_points(fx, &dxs_num); 
+    }
+    lid->add(nx, fx, dxs, dxs_num); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* Block Newton on the leaves of a tree: the leaves partition the data */
+/* points, so the Hessian of the block is diagonal and every step is  */
+/* the per-leaf Newton step.  Steps after the first take the loss     */
+/* derivatives at p plus the accumulated change of each leaf (v_sum), */
+/* so that p is written only once at the end.                         */
+/*--------------------------------------------------------*/
+void AzOptOnTree::update_leaves_of_tree(
+                      const AzOptOnTree_LeafIds *lid, 
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  const double *fixed_dw = NULL; 
+  if (!AzDvect::isNull(&v_fixed_dw)) fixed_dw = v_fixed_dw.point(); 
+
+  int leaf_num = lid->leafNum(); 
+  const int *fxs = lid->fxs(); 
+  AzDvect v_nega_dL(leaf_num), v_ddL(leaf_num), v_sum(leaf_num); 
+  AzIntArr ia_count; 
+  double *nega_dL = v_nega_dL.point_u(), *ddL = v_ddL.point_u(); 
+  double *sum = v_sum.point_u(); 
+  int *count = NULL; 
+
+  int data_num = v_p.rowNum(); 
+  const unsigned short *ids = lid->point(); 
+  double *p = v_p.point_u(); 
+  bool isQuadratic = (loss_type == AzLoss_Square || loss_type == AzLoss_LS); 
+  AzRgf_forDelta my_for_del; 
+  int step; 
+  for (step = 0; step < block_newton; ++step) {
+    const double *offs = (step == 0) ? NULL : sum; 
+    if (step == 0 || !isQuadratic) {
+      v_nega_dL.zeroOut(); 
+      v_ddL.zeroOut(); 
+      ia_count.reset(leaf_num, 0); 
+      count = ia_count.point_u(); 
+      if (doOptParallel) {
+        AzLoss::sum_deriv_by_id_par(loss_type, ids, data_num, leaf_num, 
+                                p, v_y.point(), fixed_dw, py_avg, 
+                                nega_dL, ddL, count, offs); 
+      }
+      else {
+        AzLoss::sum_deriv_by_id(loss_type, ids, data_num, leaf_num, 
+                                p, v_y.point(), fixed_dw, py_avg, 
+                                nega_dL, ddL, count, offs); 
+      }
+    }
+
+    bool isChanged = false; 
+    int id; 
+    for (id = 0; id < leaf_num; ++id) {
+      if (count[id] <= 0) continue; 
+      int fx = fxs[id]; 
+      double w = v_w.get(fx); 
+      double my_nlam = reg_depth->apply(nlam, node(fx)->depth); 
+      double my_nsig = reg_depth->apply(nsig, node(fx)->depth); 
+      double delta = getDelta(w, my_nlam, my_nsig, nega_dL[id], ddL[id], &my_for_del); 
+      if (delta == 0) continue; 
       v_w.set(fx, w+delta); 
-      updatePred(dxs, dxs_num, delta, &v_p); 
+      sum[id] += delta; 
+      if (isQuadratic) nega_dL[id] -= ddL[id]*delta; /* derivative at the new weight */
+      isChanged = true; 
     }
-    ens->tree_u(tx)->releaseDataIndexes(); 
+    if (!isChanged) break; 
+  }
+
+  /*---  count each leaf once however many steps were taken  ---*/
+  for_del->truncated += my_for_del.truncated; 
+  int id; 
+  for (id = 0; id < leaf_num; ++id) {
+    double delta = sum[id]; 
+    for_del->check_delta(&delta, -1); 
+  }
+
+  int dx; 
+#pragma omp parallel for if(doOptParallel)
+  for (dx = 0; dx < data_num; ++dx) {
+    int id = ids[dx]; 
+    if (id < leaf_num) p[dx] += sum[id]; 
   }
 }
 
+/*--------------------------------------------------------*/
+/* L-BFGS over the weights of all the features (OWL-QN if nsig>0):    */
+/* one call is one iteration.  The gradient and the diagonal of the   */
+/* Hessian (used to scale the initial Hessian) are sums of the loss   */
+/* derivatives over the data points of each feature; the predictions  */
+/* along the search direction are p + alpha*Xd, so the line search    */
+/* doesn't go over the trees again.                                   */
+/*--------------------------------------------------------*/
+void AzOptOnTree::_update_with_features_LBFGS(
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_del) /* updated */
+{
+  int f_num = tree_feat->featNum(); 
+  int data_num = v_p.rowNum(); 
+  if (lbfgs.dim() != f_num) {
+    lbfgs.reset(f_num, lbfgs_mem); 
+  }
+  else if (lbfgs.hasPrev && py_avg != lbfgs.py_avg) {
+    lbfgs.rescale(AzLoss::lamScale(py_avg-lbfgs.py_avg)); 
+  }
+  lbfgs.py_avg = py_avg; 
+
+  /*---  regularization of each feature; -1 if removed  ---*/
+  AzDvect v_lam(f_num), v_sig(f_num); 
+  double *lam = v_lam.point_u(), *sig = v_sig.point_u(); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    if (tree_feat->featInfo(fx)->isRemoved) {
+      lam[fx] = sig[fx] = -1; 
+      continue; 
+    }
+    lam[fx] = reg_depth->apply(nlam, node(fx)->depth); 
+    sig[fx] = (nsig > 0) ? reg_depth->apply(nsig, node(fx)->depth) : 0; 
+  }
+
+  /*---  loss derivatives w.r.t. the predictions  ---*/
+  const double *fixed_dw = NULL; 
+  if (!AzDvect::isNull(&v_fixed_dw)) fixed_dw = v_fixed_dw.point(); 
+  AzDvect v_r(data_num), v_h(data_num); 
+  double *r = v_r.point_u(), *h = v_h.point_u(); 
+  const double *p = v_p.point(), *y = v_y.point(); 
+  int dx; 
+  AzException *err = NULL; 
+#pragma omp parallel for if(doOptParallel)
+  for (dx = 0; dx < data_num; ++dx) {
+    try {
+      AzLosses o = AzLoss::getLosses(loss_type, p[dx], y[dx], py_avg); 
+      double dw = (fixed_dw == NULL) ? 1 : fixed_dw[dx]; 
+      r[dx] = -o._loss1*dw; 
+      h[dx] = o.loss2*dw; 
+    }
+    catch (AzException *e) {
+      AzException::keepFirst(e, &err); 
+    }
+  }
+  if (err != NULL) throw err; 
+
+  /*---  gradient, pseudo-gradient, and the inverse of the diagonal  ---*/
+  AzDvect v_g(f_num), v_hd(f_num), v_pg(f_num), v_dinv(f_num); 
+  lbfgs_sum(&v_r, &v_h, &v_g, &v_hd); 
+  double *g = v_g.point_u(), *pg = v_pg.point_u(), *dinv = v_dinv.point_u(); 
+  const double *hd = v_hd.point(); 
+  const double *w = v_w.point(); 
+  for (fx = 0; fx < f_num; ++fx) {
+    if (lam[fx] < 0) continue; 
+    g[fx] += lam[fx]*w[fx]; 
+    pg[fx] = g[fx]; 
+    if (sig[fx] > 0) {
+      if      (w[fx] > 0)         pg[fx] = g[fx] + sig[fx]; 
+      else if (w[fx] < 0)         pg[fx] = g[fx] - sig[fx]; 
+      else if (g[fx]+sig[fx] < 0) pg[fx] = g[fx] + sig[fx]; 
+      else if (g[fx]-sig[fx] > 0) pg[fx] = g[fx] - sig[fx]; 
+      else                        pg[fx] = 0; 
+    }
+    double hh = hd[fx] + lam[fx]; 
+    if (hh > 0) dinv[fx] = 1/hh; 
+  }
+  if (lbfgs.hasPrev) {
+    AzDvect v_s(&v_w), v_dg(&v_g); 
+    v_s.add(&lbfgs.v_w_prev, -1); 
+    v_dg.add(&lbfgs.v_g_prev, -1); 
+    lbfgs.push(&v_s, &v_dg); 
+  }
+
+  /*---  search direction; restart from the scaled gradient if it isn't a descent direction  ---*/
+  AzDvect v_d(f_num); 
+  double *d = NULL; 
+  double gd = 0; 
+  int trial; 
+  for (trial = 0; trial < 2; ++trial) {
+    if (trial > 0) lbfgs.forget(); 
+    lbfgs.direction(&v_pg, &v_dinv, &v_d); 
+    d = v_d.point_u(); 
+    gd = 0; 
+    for (fx = 0; fx < f_num; ++fx) {
+      if (sig[fx] > 0 && d[fx]*pg[fx] >= 0) d[fx] = 0; /* stay in the orthant */
+      gd += d[fx]*pg[fx]; 
+    }
+    if (gd < 0) break; 
+  }
+  lbfgs.v_w_prev.set(&v_w); 
+  lbfgs.v_g_prev.set(&v_g); 
+  lbfgs.hasPrev = false; 
+  if (gd >= 0) return; /* nothing to do */
+
+  /*---  line search  ---*/
+  AzDvect v_q(data_num); 
+  lbfgs_multiply(&v_d, &v_q); 
+  double obj0 = lbfgs_objective(&v_p, &v_w, &v_lam, &v_sig, py_avg); 
+  AzDvect v_w_new(f_num), v_p_new(data_num), v_corr(f_num); 
+  double *w_new = v_w_new.point_u(); 
+  double alpha = 1; 
+  bool isAccepted = false; 
+  const int ls_max = 30; 
+  int ls; 
+  for (ls = 0; ls < ls_max; ++ls) {
+    bool doCorr = false; 
+    double dec = 0; 
+    for (fx = 0; fx < f_num; ++fx) {
+      w_new[fx] = w[fx] + alpha*d[fx]; 
+      if (sig[fx] > 0) {
+        /*---  project onto the orthant of w (of -pg where w is zero)  ---*/
+        double xi = (w[fx] != 0) ? w[fx] : -pg[fx]; 
+        if (w_new[fx]*xi <= 0 && w_new[fx] != 0) {
+          v_corr.set(fx, -w_new[fx]); 
+          w_new[fx] = 0; 
+          doCorr = true; 
+        }
+      }
+      dec += pg[fx]*(w_new[fx]-w[fx]); 
+    }
+    v_p_new.set(&v_p); 
+    v_p_new.add(&v_q, alpha); 
+    if (doCorr) {
+      lbfgs_multiply(&v_corr, &v_p_new); 
+      v_corr.zeroOut(); 
+    }
+    double obj1 = lbfgs_objective(&v_p_new, &v_w_new, &v_lam, &v_sig, py_avg); 
+    if (obj1 <= obj0 + 1e-4*dec) {
+      isAccepted = true; 
+      break; 
+    }
+    /*---  minimizer of the quadratic interpolation, kept in [0.1, 0.5] of alpha  ---*/
+    double denom = 2*(obj1 - obj0 - gd*alpha); 
+    double next_alpha = (denom > 0) ? -gd*alpha*alpha/denom : alpha/2; 
+    alpha = MAX(alpha*0.1, MIN(alpha*0.5, next_alpha)); 
+  }
+  if (!isAccepted) {
+    lbfgs.forget(); 
+    return; 
+  }
+
+  for (fx = 0; fx < f_num; ++fx) {
+    if (lam[fx] < 0) continue; 
+    double delta = w_new[fx] - w[fx]; 
+    for_del->check_delta(&delta, -1); 
+  }
+  v_w.set(&v_w_new); 
+  v_p.set(&v_p_new); 
+  lbfgs.hasPrev = true; 
+}
+
+/*--------------------------------------------------------*/
+/* g[fx] = sum of r over the data points of feature fx; hd likewise.  */
+/* Each feature is summed by one thread, so the results don't depend */
+/* on the number of threads.                                         */
+void AzOptOnTree::lbfgs_sum(const AzDvect *v_r, const AzDvect *v_h, 
+                            AzDvect *v_g, AzDvect *v_hd) /* output */
+const 
+{
+  const double *r = v_r->point(), *h = v_h->point(); 
+  double *g = v_g->point_u(), *hd = v_hd->point_u(); 
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size(); 
+  int tx; 
+  for (tx = 0; tx < tree_num; ++tx) {
+    if (doTemp) {
+      ens->tree_u(tx)->restoreDataIndexes(); 
+      if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); 
+    }
+    AzIntArr ia_fx; 
+    leafFeatIds(tx, &ia_fx); 
+    const int *fxs = ia_fx.point(); 
+    int num = ia_fx.size(); 
+    int ix; 
+    AzException *err = NULL; 
+#pragma omp parallel for if(doOptParallel) schedule(dynamic)
+    for (ix = 0; ix < num; ++ix) {
+      try {
+        int dxs_num; 
+        const int *dxs = data_points(fxs[ix], &dxs_num); 
+        double g_sum = 0, h_sum = 0; 
+        int jx; 
+        for (jx = 0; jx < dxs_num; ++jx) {
+          g_sum += r[dxs[jx]]; 
+          h_sum += h[dxs[jx]]; 
+        }
+        g[fxs[ix]] = g_sum; 
+        hd[fxs[ix]] = h_sum; 
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+    if (doTemp) ens->tree_u(tx)->releaseDataIndexes(); 
+  }
+}
+
+/*--------------------------------------------------------*/
+/* v_q += X v_d.  Trees whose features are all zero in v_d are skipped. */
+void AzOptOnTree::lbfgs_multiply(const AzDvect *v_d, 
+                                 AzDvect *v_q) /* inout */
+const 
+{
+  const double *d = v_d->point(); 
+  double *q = v_q->point_u(); 
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size(); 
+  int tx; 
+  for (tx = 0; tx < tree_num; ++tx) {
+    AzIntArr ia_all_fx, ia_fx; 
+    bool isLeafOnly = leafFeatIds(tx, &ia_all_fx); 
+    int ix; 
+    for (ix = 0; ix < ia_all_fx.size(); ++ix) {
+      if (d[ia_all_fx.get(ix)] != 0) ia_fx.put(ia_all_fx.get(ix)); 
+    }
+    if (ia_fx.size() <= 0) continue; 
+    if (doTemp) ens->tree_u(tx)->restoreDataIndexes(); 
+    const int *fxs = ia_fx.point(); 
+    int num = ia_fx.size(); 
+    AzException *err = NULL; 
+#pragma omp parallel for if(doOptParallel && isLeafOnly) schedule(dynamic)
+    for (ix = 0; ix < num; ++ix) {
+      try {
+        int dxs_num; 
+        const int *dxs = data_points(fxs[ix], &dxs_num); 
+        double val = d[fxs[ix]]; 
+        int jx; 
+        for (jx = 0; jx < dxs_num; ++jx) q[dxs[jx]] += val; 
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+    if (doTemp) ens->tree_u(tx)->releaseDataIndexes(); 
+  }
+}
+
+/*--------------------------------------------------------*/
+double AzOptOnTree::lbfgs_objective(const AzDvect *v_pred, 
+                                    const AzDvect *v_wgt, 
+                                    const AzDvect *v_lam, 
+                                    const AzDvect *v_sig, 
+                                    double py_avg) 
+const 
+{
+  const double *fixed_dw = NULL; 
+  if (!AzDvect::isNull(&v_fixed_dw)) fixed_dw = v_fixed_dw.point(); 
+  double obj = AzLoss::sum_loss(loss_type, v_pred->rowNum(), v_pred->point(), 
+                                v_y.point(), fixed_dw, py_avg); 
+  const double *w = v_wgt->point(), *lam = v_lam->point(), *sig = v_sig->point(); 
+  int fx; 
+  for (fx = 0; fx < v_wgt->rowNum(); ++fx) {
+    if (lam[fx] < 0) continue; 
+    obj += lam[fx]*w[fx]*w[fx]/2 + sig[fx]*fabs(w[fx]); 
+  }
+  return obj; 
+}
+
+/*--------------------------------------------------------*/
+void AzOptOnTree_Lbfgs::push(const AzDvect *v_s, const AzDvect *v_y)
+{
+  double sy = v_s->innerProduct(v_y); 
+  if (!(sy > 1e-10*sqrt(v_s->selfInnerProduct()*v_y->selfInnerProduct()))) {
+    return; /* keep the approximation positive definite */
+  }
+  m_s.col_u(next)->set(v_s); 
+  m_y.col_u(next)->set(v_y); 
+  v_rho.set(next, 1/sy); 
+  next = (next+1) % mem; 
+  num = MIN(num+1, mem); 
+}
+
+/*--------------------------------------------------------*/
+void AzOptOnTree_Lbfgs::rescale(double scale)
+{
+  int ix; 
+  for (ix = 0; ix < num; ++ix) {
+    m_y.col_u(ix)->multiply(scale); 
+    v_rho.set(ix, v_rho.get(ix)/scale); 
+  }
+  v_g_prev.multiply(scale); 
+}
+
+/*--------------------------------------------------------*/
+/* Two-loop recursion; the initial Hessian is the diagonal (its     */
+/* inverse v_dinv) scaled by s'y/y'Dy of the latest pair.           */
+void AzOptOnTree_Lbfgs::direction(const AzDvect *v_g, 
+                                  const AzDvect *v_dinv, 
+                                  AzDvect *v_d) /* output */
+const 
+{
+  AzDvect v_alpha(mem); 
+  v_d->set(v_g); 
+  int ix; 
+  for (ix = 0; ix < num; ++ix) {
+    int pos = (next-1-ix+mem) % mem; /* newest first */
+    double alpha = v_rho.get(pos) * m_s.col(pos)->innerProduct(v_d); 
+    v_alpha.set(pos, alpha); 
+    v_d->add(m_y.col(pos), -alpha); 
+  }
+  double gamma = 1; 
+  if (num > 0) {
+    int pos = (next-1+mem) % mem; 
+    AzDvect v_dy(m_y.col(pos)); 
+    v_dy.scale(v_dinv); 
+    double ydy = v_dy.innerProduct(m_y.col(pos)); 
+    if (ydy > 0) gamma = 1/(v_rho.get(pos)*ydy); 
+  }
+  v_d->scale(v_dinv); 
+  v_d->multiply(gamma); 
+  for (ix = num-1; ix >= 0; --ix) {
+    int pos = (next-1-ix+mem) % mem; /* oldest first */
+    double beta = v_rho.get(pos) * m_y.col(pos)->innerProduct(v_d); 
+    v_d->add(m_s.col(pos), v_alpha.get(pos)-beta); 
+  }
+  v_d->multiply(-1); 
+}
+
 /*--------------------------------------------------------*/
 void AzOptOnTree::update_with_features(
                       double nlam, 
@@ -352,7 +1027,19 @@ void AzOptOnTree::update_with_features(
                       double py_avg, 
                       AzRgf_forDelta *for_del) /* updated */
 {
-  if (ens->usingTempFile()) {
+  if (doActiveSet) {
+    _update_with_features_Active(nlam, nsig, py_avg, for_del); 
+  }
+  else if (doOptLBFGS) {
+    _update_with_features_LBFGS(nlam, nsig, py_avg, for_del); 
+  }
+  else if (doOptByTree) {
+    _update_with_features_ByTree(nlam, nsig, py_avg, for_del); 
+  }
+  else if (doOptParallel) {
+    _update_with_features_Parallel(nlam, nsig, py_avg, for_del); 
+  }
+  else if (ens->usingTempFile()) {
     _update_with_features_TempFile(nlam, nsig, py_avg, for_del); 
   }
   else {
@@ -407,7 +1094,11 @@ const
   const double *y = v_y.point(); 
 
   double nega_dL = 0, ddL= 0; 
-  if (fixed_dw == NULL) {
+  if (doOptParallel) {
+    AzLoss::sum_deriv_par(loss_type, dxs, dxs_num, p, y, fixed_dw, py_avg, 
+                          nega_dL, ddL); 
+  }
+  else if (fixed_dw == NULL) {
     AzLoss::sum_deriv(loss_type, dxs, dxs_num, p, y, py_avg, 
                       nega_dL, ddL); 
   }
@@ -415,7 +1106,19 @@ const
     AzLoss::sum_deriv_weighted(loss_type, dxs, dxs_num, p, y, fixed_dw, py_avg, 
                       nega_dL, ddL); 
   }
+  return getDelta(w, nlam, nsig, nega_dL, ddL, for_del); 
+}
 
+/*--------------------------------------------------------*/
+double AzOptOnTree::getDelta(double w,
+                             double nlam, 
+                             double nsig, 
+                             double nega_dL, 
+                             double ddL, 
+                             /*---  inout  ---*/
+                             AzRgf_forDelta *for_del) /* updated */
+const 
+{
   double ddL_nlam = ddL + nlam; 
   if (ddL_nlam == 0) ddL_nlam = 1;  /* this shouldn't happen, though */
   double delta = (nega_dL-nlam*w)*eta/ddL_nlam; 
@@ -446,6 +1149,27 @@ void AzOptOnTree::checkParam() const
   if (eta <= 0) {
     throw new AzException(AzInputNotValid, eyec, kw_eta, "must be positive"); 
   }
+  if (lbfgs_mem <= 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_lbfgs_mem, "must be positive"); 
+  }
+  if (block_newton <= 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_block_newton, "must be positive"); 
+  }
+  if (block_newton != block_newton_dflt && !doOptByTree) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_block_newton, "requires OptimizeByTree"); 
+  }
+  if (active_full < 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_active_full, "must be non-negative"); 
+  }
+  if (doOptLBFGS && doOptByTree) {
+    throw new AzException(AzInputNotValid, eyec, kw_doOptLBFGS, "can't be used with OptimizeByTree"); 
+  }
+  if (doOptLBFGS && active_full > 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_doOptLBFGS, "can't be used with opt_active_full"); 
+  }
+  if (shotgun_num < 1) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_shotgun, "must be positive"); 
+  }
 }
 
 /*--------------------------------------------------------*/
@@ -478,16 +1202,75 @@ AzOptOnTree::optimize(AzRgfTreeEnsemble *rgf_ens,
 {
   ens = rgf_ens; 
   tree_feat = inp_tree_feat; 
+  int old_f_num = v_w.rowNum(); 
   synchronize(); 
   if (doRefreshP) {
     refreshPred(); 
   }
-  iterate(ite_num, lam, sig); 
+  isPartial = iterate_active(old_f_num, ite_num, lam, sig); 
+  if (!isPartial) {
+    active_count = 0; 
+    iterate(ite_num, lam, sig); 
+  }
   updateTreeWeights(rgf_ens); 
   ens = NULL; 
   tree_feat = NULL; 
 }
 
+/*--------------------------------------------------------*/
+/* Optimize the features added since the last call (new leaves, */
+/* including the children of split leaves) unless it is time to */
+/* go over all.  Return false if all need to be optimized.      */
+/*--------------------------------------------------------*/
+bool AzOptOnTree::iterate_active(int old_f_num, 
+                                 int ite_num, 
+                                 double lam, 
+                                 double sig)
+{
+  bool doFull = (active_full <= 0 || doFullNext || active_count+1 >= active_full); 
+  doFullNext = false; 
+  if (doFull) return false; 
+
+  ia_active_fx.reset(); 
+  int f_num = tree_feat->featNum(); 
+  int fx; 
+  for (fx = old_f_num; fx < f_num; ++fx) {
+    if (!tree_feat->featInfo(fx)->isRemoved) ia_active_fx.put(fx); 
+  }
+  ++active_count; 
+  AzBytArr s("Optimizing "); s.cn(ia_active_fx.size()); s.c(" new features"); 
+  AzTimeLog::print(s, out); 
+  if (ia_active_fx.size() <= 0) return true; 
+
+  double loss0 = getLoss(); 
+  doActiveSet = true; 
+  iterate(ite_num, lam, sig); 
+  doActiveSet = false; 
+  ia_active_fx.reset(); 
+  double loss1 = getLoss(); 
+  if (loss0-loss1 < active_stall*loss0) {
+    AzTimeLog::print("Loss decrease stalled; going over all features", out); 
+    return false; 
+  }
+  return true; 
+}
+
+/*--------------------------------------------------------*/
+double AzOptOnTree::getLoss() const 
+{
+  const double *y = v_y.point(); 
+  const double *p = v_p.point(); 
+  const double *fixed_dw = NULL; 
+  double nn = v_y.rowNum(); 
+  if (!AzDvect::isNull(&v_fixed_dw)) {
+    fixed_dw = v_fixed_dw.point(); 
+    nn = v_fixed_dw.sum(); 
+  }
+  double loss_sum = AzLoss::sum_loss(loss_type, v_p.rowNum(), p, y, fixed_dw); 
+  if (nn != 0) loss_sum /= nn; 
+  return loss_sum; 
+}
+
 /*------------------------------------------------------------------*/
 void AzOptOnTree::updateTreeWeights(AzRgfTreeEnsemble *ens) const
 {
@@ -544,6 +1327,7 @@ void AzOptOnTree::_refreshPred_TempFile()
   int tx; 
   for (tx = 0; tx < tree_num; ++tx) {
     ens->tree_u(tx)->restoreDataIndexes(); 
+    if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); 
     AzIIarr iia_nx_fx; 
     tree_feat->featIds(tx, &iia_nx_fx); 
     int num = iia_nx_fx.size(); 
@@ -561,10 +1345,52 @@ void AzOptOnTree::_refreshPred_TempFile()
   }
 }
 
+/*--------------------------------------------------------*/
+void AzOptOnTree::_refreshPred_Parallel()
+{
+  if (v_w.rowNum() == 0 && v_p.rowNum() == 0) return; 
+
+  v_p.zeroOut(); 
+  v_p.set(var_const+fixed_const);  
+
+  const double *w = v_w.point(); 
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size(); 
+  int tx; 
+  for (tx = 0; tx < tree_num; ++tx) {
+    if (doTemp) {
+      ens->tree_u(tx)->restoreDataIndexes(); 
+      if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); 
+    }
+    AzIntArr ia_fx; 
+    bool isLeafOnly = leafFeatIds(tx, &ia_fx); 
+    const int *fxs = ia_fx.point(); 
+    int num = ia_fx.size(); 
+    int ix; 
+    AzException *err = NULL; 
+#pragma omp parallel for if(isLeafOnly) schedule(dynamic)
+    for (ix = 0; ix < num; ++ix) {
+      try {
+        int dxs_num; 
+        const int *dxs = data_points(fxs[ix], &dxs_num); 
+        updatePred(dxs, dxs_num, w[fxs[ix]], &v_p); 
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+    if (doTemp) ens->tree_u(tx)->releaseDataIndexes(); 
+  }
+}
+
 /*--------------------------------------------------------*/
 void AzOptOnTree::refreshPred()
 {
-  if (ens->usingTempFile()) {
+  if (doOptParallel) {
+    _refreshPred_Parallel(); 
+  }
+  else if (ens->usingTempFile()) {
     _refreshPred_TempFile(); 
   }
   else {
@@ -580,13 +1406,13 @@ const
   int data_num = b_tran->rowNum(); 
   out_v_p->reform(data_num); 
   out_v_p->set(var_const+fixed_const); 
+  double *p = out_v_p->point_u(); 
   AzCursor cursor; 
   for ( ; ; ) {
     double val; 
     int fx = v_w.next(cursor, val); 
     if (fx < 0) break; 
-    const AzIntArr *ia_dx = b_tran->on_rows(fx); 
-    updatePred(ia_dx->point(), ia_dx->size(), val, out_v_p); 
+    b_tran->add_to(fx, val, p); 
   }  
 }
  
@@ -632,6 +1458,14 @@ void AzOptOnTree::printHelp(AzHelp &h) const
   h.item_experimental(kw_doIntercept, help_doIntercept); 
   h.item(kw_eta, help_eta, eta_dflt); 
   h.item_experimental(kw_exit_delta, help_exit_delta, exit_delta_dflt); 
+  h.item_experimental(kw_doOptByTree, help_doOptByTree); 
+  h.item_experimental(kw_opt_block_newton, help_opt_block_newton, block_newton_dflt); 
+  h.item_experimental(kw_doOptLBFGS, help_doOptLBFGS); 
+  h.item_experimental(kw_opt_lbfgs_mem, help_opt_lbfgs_mem, lbfgs_mem_dflt); 
+  h.item_experimental(kw_doOptParallel, help_doOptParallel); 
+  h.item_experimental(kw_opt_shotgun, help_opt_shotgun, shotgun_num_dflt); 
+  h.item_experimental(kw_opt_active_full, help_opt_active_full, active_full_dflt); 
+  h.item_experimental(kw_opt_active_stall, help_opt_active_stall, active_stall_dflt); 
   h.end(); 
 }
 
@@ -647,6 +1481,14 @@ void AzOptOnTree::resetParam(AzParam &p)
   p.swOn(&doUseAvg, kw_doUseAvg); 
   p.swOff(&doIntercept, kw_not_doIntercept); /* useless but keep this for compatibility */
   p.swOn(&doIntercept, kw_doIntercept); 
+  p.swOn(&doOptByTree, kw_doOptByTree); 
+  p.vInt(kw_opt_block_newton, &block_newton); 
+  p.swOn(&doOptLBFGS, kw_doOptLBFGS); 
+  p.vInt(kw_opt_lbfgs_mem, &lbfgs_mem); 
+  p.swOn(&doOptParallel, kw_doOptParallel); 
+  p.vInt(kw_opt_shotgun, &shotgun_num); 
+  p.vInt(kw_opt_active_full, &active_full); 
+  p.vFloat(kw_opt_active_stall, &active_stall); 
 
   if (max_ite_num <= 0) {
     max_ite_num = max_ite_num_dflt_oth; 
@@ -676,6 +1518,16 @@ void AzOptOnTree::printParam(const AzOut &out,
 
   o.printSw(kw_doUseAvg, doUseAvg); 
   o.printSw(kw_doIntercept, doIntercept); 
+  o.printSw(kw_doOptByTree, doOptByTree); 
+  if (doOptByTree) o.printV(kw_opt_block_newton, block_newton); 
+  o.printSw(kw_doOptLBFGS, doOptLBFGS); 
+  if (doOptLBFGS) o.printV(kw_opt_lbfgs_mem, lbfgs_mem); 
+  o.printSw(kw_doOptParallel, doOptParallel); 
+  if (doOptParallel) o.printV(kw_opt_shotgun, shotgun_num); 
+  if (active_full > 0) {
+    o.printV(kw_opt_active_full, active_full); 
+    o.printV(kw_opt_active_stall, active_stall); 
+  }
 
   o.printSw(kw_opt_beVerbose, beVerbose); 
 
@@ -39,9 +39,121 @@ public:
 
   void check_delta(double *delta, //<! inout 
                    double max_delta); 
+  void merge(const AzRgf_forDelta *inp) {
+    changed += inp->changed; 
+    truncated += inp->truncated; 
+    sum_delta += inp->sum_delta; 
+    my_max = MAX(my_max, inp->my_max); 
+  }
   double avg_delta() const; 
 }; 
 
+//! leaf id of every data point for one tree; for OptimizeByTree 
+class AzOptOnTree_LeafIds {
+protected:
+  unsigned short *ids; /* [data point]: leaf id; no_id if not in any leaf */
+  AzBaseArray<unsigned short> a_ids; 
+  int data_num; 
+  AzIntArr ia_fx; /* [leaf id] feat# */
+  AzIntArr ia_nx; /* [leaf id] node#; to detect changes to the tree */
+  bool isUsable; 
+
+public:
+  static const int no_id = 0xFFFF; 
+  static const int max_leaf_num = 0xFFFF; 
+
+  AzOptOnTree_LeafIds() : ids(NULL), data_num(0), isUsable(false) {}
+  ~AzOptOnTree_LeafIds() {}
+
+  /*---  true if the features of the tree are the same as when built  ---*/
+  bool isSame(const AzIIarr *iia_nx_fx) const {
+    int num = iia_nx_fx->size(); 
+    if (num != ia_fx.size()) return false; 
+    int ix; 
+    for (ix = 0; ix < num; ++ix) {
+      int nx, fx; 
+      iia_nx_fx->get(ix, &nx, &fx); 
+      if (nx != ia_nx.get(ix) || fx != ia_fx.get(ix)) return false; 
+    }
+    return true; 
+  }
+  void begin(int inp_data_num) {
+    a_ids.free(&ids); 
+    ia_fx.reset(); 
+    ia_nx.reset(); 
+    data_num = inp_data_num; 
+    a_ids.alloc(&ids, data_num, "AzOptOnTree_LeafIds::begin", "ids"); 
+    int dx; 
+    for (dx = 0; dx < data_num; ++dx) ids[dx] = no_id; 
+    isUsable = true; 
+  }
+  /*---  call in the order of featIds  ---*/
+  void add(int nx, int fx, 
+           const int *dxs, int dxs_num) /* NULL if not usable for this */
+  {
+    int id = ia_fx.size(); 
+    ia_nx.put(nx); 
+    ia_fx.put(fx); 
+    if (!isUsable) return; 
+    if (dxs == NULL || id >= max_leaf_num) {
+      a_ids.free(&ids); 
+      isUsable = false; 
+      return; 
+    }
+    int ix; 
+    for (ix = 0; ix < dxs_num; ++ix) ids[dxs[ix]] = (unsigned short)id; 
+  }
+  inline bool usable() const { return isUsable; }
+  inline const unsigned short *point() const { return ids; }
+  inline int dataNum() const { return data_num; }
+  inline int leafNum() const { return ia_fx.size(); }
+  inline const int *fxs() const { return ia_fx.point(); }
+  inline AzInt64 memSize() const {
+    return (AzInt64)a_ids.size()*sizeof(unsigned short) + ia_fx.memSize() + ia_nx.memSize(); 
+  }
+}; 
+
+//! history of L-BFGS for OptimizeLBFGS 
+class AzOptOnTree_Lbfgs {
+protected:
+  AzDmat m_s, m_y; /* [feat#, pair#]: change of weights and of gradient */
+  AzDvect v_rho;   /* [pair#]: 1/(s'y) */
+  int mem, num, next; /* max #pairs, #pairs, where the next goes */
+
+public:
+  AzDvect v_w_prev, v_g_prev; /* weights and gradient before the last step */
+  bool hasPrev; 
+  double py_avg; /* the loss and gradient are scaled by exp(py_avg) */
+
+  AzOptOnTree_Lbfgs() : mem(0), num(0), next(0), hasPrev(false), py_avg(0) {}
+  void reset() {
+    m_s.reset(); m_y.reset(); v_rho.reset(); 
+    v_w_prev.reset(); v_g_prev.reset(); 
+    mem = num = next = 0; 
+    hasPrev = false; 
+    py_avg = 0; 
+  }
+  void reset(int dim, int inp_mem) {
+    reset(); 
+    mem = inp_mem; 
+    m_s.reform(dim, mem); 
+    m_y.reform(dim, mem); 
+    v_rho.reform(mem); 
+  }
+  void forget() {
+    num = next = 0; 
+    hasPrev = false; 
+  }
+  inline int dim() const { return m_s.rowNum(); }
+
+  void push(const AzDvect *v_s, const AzDvect *v_y); 
+  void rescale(double scale); /* the objective was scaled by this */
+  void direction(const AzDvect *v_g, 
+                 const AzDvect *v_dinv, /* inverse of the diagonal of the Hessian */
+                 AzDvect *v_d) /* output: -Hg */
+                 const; 
+}; 
+
 //! coordinate descent for weight optimization. 
 /*--------------------------------------------------------*/
 class AzOptOnTree : /* implements */ public virtual AzOptimizerT
@@ -71,10 +183,34 @@ protected:
 
   AzIntArr ia_empty; 
 
+  bool doOptByTree; 
+  AzOptOnTree_LeafIds **leaf_ids; /* [tree#]; for doOptByTree */
+  AzObjPtrArray<AzOptOnTree_LeafIds> a_leaf_ids; 
+  int block_newton; /* #Newton steps on the leaves of a tree with doOptByTree */
+
+  bool doOptLBFGS; 
+  int lbfgs_mem; 
+  AzOptOnTree_Lbfgs lbfgs; 
+
+  bool doOptParallel; 
+  int shotgun_num; /* #trees updated at once with doOptParallel */
+
+  /*---  active set: only the features added since the last call  ---*/
+  int active_full; /* go over all every this many calls; 0: off */
+  double active_stall; 
+  int active_count; /* #calls since the last full pass */
+  bool doFullNext, isPartial, doActiveSet; 
+  AzIntArr ia_active_fx; 
+
   /*---  default values  ---*/
   static const int max_ite_num_dflt_oth = 10; 
   static const int max_ite_num_dflt_expo = 5; 
   static const AzLossType loss_type_dflt = AzLoss_Square; 
+  static const int shotgun_num_dflt = 1; 
+  static const int active_full_dflt = 0; 
+  static const int block_newton_dflt = 1; 
+  static const int lbfgs_mem_dflt = 10; 
+  #define active_stall_dflt 0.0001
   #define eta_dflt 0.5
   #define exit_delta_dflt -1
   #define max_delta_dflt -1
@@ -87,7 +223,12 @@ public:
     loss_type(loss_type_dflt), max_ite_num(-1),
     doIntercept(false), /* changed on 12/09/2011 */
     doRefreshP(false), doUnregIntercept(false), doUseAvg(false),  
-    ens(NULL), tree_feat(NULL)
+    ens(NULL), tree_feat(NULL), doOptByTree(false), leaf_ids(NULL), 
+    block_newton(block_newton_dflt), 
+    doOptLBFGS(false), lbfgs_mem(lbfgs_mem_dflt), 
+    doOptParallel(false), shotgun_num(shotgun_num_dflt), 
+    active_full(active_full_dflt), active_stall(active_stall_dflt), active_count(0), 
+    doFullNext(false), isPartial(false), doActiveSet(false)
     {}
 
   ~AzOptOnTree() {}
@@ -121,6 +262,13 @@ public:
                        double lam=-1, 
                        double sig=-1); 
 
+  virtual void requestFullPass() {
+    doFullNext = true; 
+  }
+  virtual bool wasPartial() const {
+    return isPartial; 
+  }
+
   inline AzLossType lossType() const {
     return loss_type; 
   }
@@ -136,6 +284,16 @@ public:
                 int print_max = 50, 
                 bool changeLine = true) const; 
 
+  AzInt64 memSize() const {
+    AzInt64 size = v_w.memSize() + v_y.memSize() + v_p.memSize() + v_fixed_dw.memSize() 
+                 + ia_active_fx.memSize(); 
+    int tx; 
+    for (tx = 0; tx < a_leaf_ids.size(); ++tx) {
+      if (leaf_ids[tx] != NULL) size += leaf_ids[tx]->memSize(); 
+    }
+    return size; 
+  }
+
   inline void copyPred_to(AzDvect *out_v_p) const {
     out_v_p->reform(v_p.rowNum()); 
     out_v_p->set(&v_p); 
@@ -171,8 +329,15 @@ protected:
     v_y.reset(); 
     v_fixed_dw.reset(); 
     var_const = fixed_const = 0; 
+    a_leaf_ids.free(&leaf_ids); 
+    lbfgs.reset(); 
+    ia_active_fx.reset(); 
+    active_count = 0; 
+    doFullNext = isPartial = doActiveSet = false; 
   }
   void synchronize(); 
+  bool iterate_active(int old_f_num, int inp_ite_num, double lam, double sig); 
+  double getLoss() const; 
 
   void iterate(int inp_ite_num, 
                double lam, 
@@ -185,6 +350,44 @@ protected:
                             AzRgf_forDelta *for_delta);
   virtual void _update_with_features_TempFile(double nlam, double nsig, double py_avg, 
                             AzRgf_forDelta *for_delta);
+  virtual void _update_with_features_ByTree(double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta);
+  virtual void _update_with_features_Parallel(double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta);
+  virtual void _update_with_features_Active(double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta);
+  virtual void _update_with_features_LBFGS(double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta);
+  void lbfgs_sum(const AzDvect *v_r, const AzDvect *v_h, 
+                 AzDvect *v_g, AzDvect *v_hd) const; /* output: [feat#] */
+  void lbfgs_multiply(const AzDvect *v_d, AzDvect *v_q) const; /* v_q += X v_d */
+  double lbfgs_objective(const AzDvect *v_pred, const AzDvect *v_wgt, 
+                         const AzDvect *v_lam, const AzDvect *v_sig, 
+                         double py_avg) const; 
+  bool leafFeatIds(int tx, AzIntArr *ia_fx) const; 
+  inline void update_feature(int fx, double nlam, double nsig, double py_avg, 
+                             AzRgf_forDelta *for_del) {
+    double w = v_w.get(fx); 
+    int dxs_num; 
+    const int *dxs = data_points(fx, &dxs_num); 
+    double my_nlam = reg_depth->apply(nlam, node(fx)->depth); 
+    double my_nsig = reg_depth->apply(nsig, node(fx)->depth); 
+    double delta = getDelta(dxs, dxs_num, w, my_nlam, my_nsig, py_avg, for_del); 
+    v_w.set(fx, w+delta); 
+    updatePred(dxs, dxs_num, delta, &v_p); 
+  }
+  void update_features_par(const AzIntArr *ia_fx, 
+                            const AzIntArr *ia_fx_begin, 
+                            double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta); 
+  void update_features_of_tree(const AzIIarr *iia_nx_fx, 
+                            double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta); 
+  void update_leaves_of_tree(const AzOptOnTree_LeafIds *lid, 
+                            double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta); 
+  void resetLeafIds(const AzIIarr *iia_nx_fx, 
+                    AzOptOnTree_LeafIds *lid) const; /* output */
   void update_intercept(double nlam, double nsig, double py_avg, 
                         AzRgf_forDelta *for_delta); /* updated */
 
@@ -193,6 +396,11 @@ protected:
                   /*---  inout  ---*/
                   AzRgf_forDelta *for_delta) 
                   const; 
+  double getDelta(double w, double nlam, double nsig, 
+                  double nega_dL, double ddL, 
+                  /*---  inout  ---*/
+                  AzRgf_forDelta *for_delta) 
+                  const; 
 
   virtual void checkParam() const; 
 
@@ -220,6 +428,7 @@ protected:
   virtual void refreshPred(); 
   virtual void _refreshPred(); 
   virtual void _refreshPred_TempFile(); 
+  virtual void _refreshPred_Parallel(); 
   inline static void updatePred(const int *dxs, int dxs_num, double delta, 
                                 AzDvect *out_v_p) {
     out_v_p->add(delta, dxs, dxs_num);   
@@ -41,9 +41,21 @@ AzOptOnTree_TreeReg::optimize(AzRgfTreeEnsemble *inp_rgf_ens,
   }
   int tx; 
   for (tx = 0; tx < tree_num; ++tx) {
-    AzReg_TreeReg *reg = reg_arr->reg(tx);  
-    reg->reset(ens->tree(tx), reg_depth); 
+    reg_arr->reg(tx)->prepare(ens->tree(tx), reg_depth); 
   }
+  /*---  trees that haven't changed since the last time keep their state  ---*/
+  AzException *err = NULL; 
+#pragma omp parallel for if(doOptParallel) schedule(dynamic)
+  for (tx = 0; tx < tree_num; ++tx) {
+    try {
+      AzReg_TreeReg *reg = reg_arr->reg(tx);  
+      reg->reset(ens->tree(tx), reg_depth); 
+    }
+    catch (AzException *e) {
+      AzException::keepFirst(e, &err); 
+    }
+  }
+  if (err != NULL) throw err; 
   iterate(ite_num, lam, sig); 
 
   ens = NULL; 
@@ -51,6 +63,30 @@ AzOptOnTree_TreeReg::optimize(AzRgfTreeEnsemble *inp_rgf_ens,
   rgf_ens = NULL; 
 }
 
+/*--------------------------------------------------------*/
+/* The options below are implemented only by AzOptOnTree; */
+/* reject them rather than ignoring them silently.        */
+/*--------------------------------------------------------*/
+void AzOptOnTree_TreeReg::checkParam() const
+{
+  AzOptOnTree::checkParam(); 
+
+  const char *eyec = "AzOptOnTree_TreeReg::checkParam"; 
+  const char *msg = "not supported with min-penalty regularization"; 
+  if (doOptByTree) {
+    throw new AzException(AzInputNotValid, eyec, kw_doOptByTree, msg); 
+  }
+  if (block_newton != block_newton_dflt) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_block_newton, msg); 
+  }
+  if (doOptLBFGS) {
+    throw new AzException(AzInputNotValid, eyec, kw_doOptLBFGS, msg); 
+  }
+  if (active_full > 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_opt_active_full, msg); 
+  }
+}
+
 /*--------------------------------------------------------*/
 void AzOptOnTree_TreeReg::update_with_features(
                       double nlam, 
@@ -58,10 +94,16 @@ void AzOptOnTree_TreeReg::update_with_features(
                       double py_avg, 
                       AzRgf_forDelta *for_delta) /* updated */
 {
+  if (doOptParallel) {
+    _update_with_features_Parallel(nlam, nsig, py_avg, for_delta); 
+    return; 
+  }
+
   int tree_num = ens->size();
   int tx; 
   for (tx = 0; tx < tree_num; ++tx) {
     ens->tree_u(tx)->restoreDataIndexes(); 
+    if (tx+1 < tree_num) ens->tree_u(tx+1)->prefetchDataIndexes(); 
     AzReg_TreeReg *reg = reg_arr->reg(tx); 
     reg->clearFocusNode(); 
 
@@ -80,19 +122,144 @@ void AzOptOnTree_TreeReg::update_with_features(
     ens->tree_u(tx)->releaseDataIndexes(); 
   }
 }                                         
+
+/*--------------------------------------------------------*/
+/* The penalty of a tree depends only on the weights of its own leaves, */
+/* so the trees are updated in parallel, each tree leaf by leaf.  The   */
+/* leaves of a tree don't share data points, so the loss derivatives    */
+/* of all of them can be taken first: with shotgun_num=1 the result is  */
+/* the same as the sequential update.  With shotgun_num>1, the leaves   */
+/* of that many trees are all computed from the same predictions.       */
+/*--------------------------------------------------------*/
+void AzOptOnTree_TreeReg::_update_with_features_Parallel(
+                      double nlam, 
+                      double nsig, 
+                      double py_avg, 
+                      AzRgf_forDelta *for_delta) /* updated */
+{
+  const char *eyec = "AzOptOnTree_TreeReg::_update_with_features_Parallel"; 
+  bool doTemp = ens->usingTempFile(); 
+  int tree_num = ens->size();
+  int tx0; 
+  for (tx0 = 0; tx0 < tree_num; tx0 += shotgun_num) {
+    int tx1 = MIN(tree_num, tx0+shotgun_num); 
+    int tx; 
+    if (doTemp) {
+      /*---  read the next group ahead while this group is processed  ---*/
+      for (tx = tx1; tx < MIN(tree_num, tx1+shotgun_num); ++tx) ens->tree_u(tx)->prefetchDataIndexes(); 
+      for (tx = tx0; tx < tx1; ++tx) ens->tree_u(tx)->restoreDataIndexes(); 
+    }
+
+    /*---  features of the trees; where each tree begins  ---*/
+    AzIntArr ia_nx, ia_fx, ia_begin; 
+    for (tx = tx0; tx < tx1; ++tx) {
+      ia_begin.put(ia_fx.size()); 
+      AzIIarr iia_nx_fx; 
+      tree_feat->featIds(tx, &iia_nx_fx); 
+      int ix; 
+      for (ix = 0; ix < iia_nx_fx.size(); ++ix) {
+        int nx, fx; 
+        iia_nx_fx.get(ix, &nx, &fx); 
+        if (!node(fx)->isLeaf()) {
+          throw new AzException(eyec, "can't coexist with UseInternalNodes"); 
+        }
+        ia_nx.put(nx); 
+        ia_fx.put(fx); 
+      }
+    }
+    ia_begin.put(ia_fx.size()); 
+    int num = ia_fx.size(); 
+    const int *nxs = ia_nx.point(), *fxs = ia_fx.point(), *begin = ia_begin.point(); 
+
+    /*---  loss derivatives  ---*/
+    AzDvect v_nega_dL(num), v_ddL(num), v_delta(num); 
+    double *nega_dL = v_nega_dL.point_u(), *ddL = v_ddL.point_u(); 
+    double *delta = v_delta.point_u(); 
+    int ix; 
+    AzException *err = NULL; 
+#pragma omp parallel for schedule(dynamic)
+    for (ix = 0; ix < num; ++ix) {
+      try {
+        loss_deriv(fxs[ix], py_avg, &nega_dL[ix], &ddL[ix]); 
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+
+    /*---  weights  ---*/
+    int t_num = tx1 - tx0; 
+    AzRgf_forDelta *fd = NULL; 
+    AzBaseArray<AzRgf_forDelta> a_fd; 
+    a_fd.alloc(&fd, t_num, eyec, "for_delta"); 
+    int tt; 
+#pragma omp parallel for schedule(dynamic)
+    for (tt = 0; tt < t_num; ++tt) {
+      try {
+        AzReg_TreeReg *reg = reg_arr->reg(tx0+tt); 
+        reg->clearFocusNode(); 
+        int jx; 
+        for (jx = begin[tt]; jx < begin[tt+1]; ++jx) {
+          delta[jx] = newtonDelta(nxs[jx], reg, nlam, nega_dL[jx], ddL[jx], &fd[tt]); 
+          set_weight(nxs[jx], fxs[jx], delta[jx], reg); 
+        }
+      }
+      catch (AzException *e) {
+        AzException::keepFirst(e, &err); 
+      }
+    }
+    if (err != NULL) throw err; 
+    /*---  in the order of trees so that the result is deterministic  ---*/
+    for (tt = 0; tt < t_num; ++tt) {
+      for_delta->merge(&fd[tt]); 
+    }
+
+    /*---  predictions: leaves of different trees may share data points  ---*/
+    for (tt = 0; tt < t_num; ++tt) {
+#pragma omp parallel for schedule(dynamic)
+      for (ix = begin[tt]; ix < begin[tt+1]; ++ix) {
+        if (delta[ix] == 0) continue; 
+        try {
+          int dxs_num; 
+          const int *dxs = data_points(fxs[ix], &dxs_num); 
+          updatePred(dxs, dxs_num, delta[ix], &v_p); 
+        }
+        catch (AzException *e) {
+          AzException::keepFirst(e, &err); 
+        }
+      }
+      if (err != NULL) throw err; 
+    }
+    if (doTemp) {
+      for (tx = tx0; tx < tx1; ++tx) ens->tree_u(tx)->releaseDataIndexes(); 
+    }
+  }
+}
+
 /*--------------------------------------------------------*/
 void AzOptOnTree_TreeReg::update_weight(int nx, 
                                    int fx, 
                                    double delta,
                                    AzReg_TreeReg *reg)
 {
-  double new_w = v_w.get(fx) + delta; 
-  v_w.set(fx, new_w); 
-
   int dxs_num; 
   const int *dxs = data_points(fx, &dxs_num); 
   updatePred(dxs, dxs_num, delta, &v_p); 
 
+  set_weight(nx, fx, delta, reg); 
+}
+
+/*--------------------------------------------------------*/
+/* everything but the predictions */
+void AzOptOnTree_TreeReg::set_weight(int nx, 
+                                   int fx, 
+                                   double delta,
+                                   AzReg_TreeReg *reg)
+{
+  double new_w = v_w.get(fx) + delta; 
+  v_w.set(fx, new_w); 
+
   /*---  update the weight in the ensemble  ---*/ 
   const AzTrTreeFeatInfo *fp = tree_feat->featInfo(fx); 
   rgf_ens->tree_u(fp->tx)->setWeight(fp->nx, new_w); 
@@ -110,9 +277,21 @@ double AzOptOnTree_TreeReg::bestDelta(
                       AzRgf_forDelta *for_delta) /* updated */
 const
 {
-  const char *eyec = "AzOptOnTree_TI::bestDelta"; 
+  double nega_dL = 0, ddL= 0; 
+  loss_deriv(fx, py_avg, &nega_dL, &ddL); 
+  return newtonDelta(nx, reg, nlam, nega_dL, ddL, for_delta); 
+}
+
+/*--------------------------------------------------------*/
+void AzOptOnTree_TreeReg::loss_deriv(
+                      int fx, 
+                      double py_avg, 
+                      double *out_nega_dL, /* output */
+                      double *out_ddL) /* output */
+const
+{
+  const char *eyec = "AzOptOnTree_TreeReg::loss_deriv"; 
 
-  double w = v_w.get(fx); 
   int dxs_num; 
   const int *dxs = data_points(fx, &dxs_num); 
   if (dxs_num <= 0) {
@@ -132,7 +311,20 @@ const
     AzLoss::sum_deriv_weighted(loss_type, dxs, dxs_num, p, y, fixed_dw, py_avg, 
                       nega_dL, ddL);
   }
+  *out_nega_dL = nega_dL; 
+  *out_ddL = ddL; 
+}
 
+/*--------------------------------------------------------*/
+double AzOptOnTree_TreeReg::newtonDelta(
+                      int nx, 
+                      AzReg_TreeReg *reg, 
+                      double nlam, 
+                      double nega_dL, 
+                      double ddL, 
+                      AzRgf_forDelta *for_delta) /* updated */
+const
+{
   double dR, ddR; 
   reg->penalty_deriv(nx, &dR, &ddR); 
 
@@ -50,14 +50,23 @@ public:
   }
 
 protected: 
+  //! override 
+  virtual void checkParam() const; 
   //! override 
   virtual void update_with_features(double nlam, double nsig, double py_avg, 
                             AzRgf_forDelta *for_delta); 
+  //! override 
+  virtual void _update_with_features_Parallel(double nlam, double nsig, double py_avg, 
+                            AzRgf_forDelta *for_delta); 
 
   virtual void update_weight(int nx, 
                              int fx, 
                              double delta, 
                              AzReg_TreeReg *reg); 
+  virtual void set_weight(int nx, 
+                          int fx, 
+                          double delta, 
+                          AzReg_TreeReg *reg); 
   virtual double bestDelta(
                       int nx, 
                       int fx, 
@@ -67,6 +76,19 @@ protected:
                       double py_avg, 
                       AzRgf_forDelta *for_delta) /* updated */
                       const; 
+  virtual void loss_deriv(int fx, 
+                          double py_avg, 
+                          double *nega_dL, /* output */
+                          double *ddL) /* output */
+                          const; 
+  virtual double newtonDelta(
+                      int nx, 
+                      AzReg_TreeReg *reg, 
+                      double nlam, 
+                      double nega_dL, 
+                      double ddL, 
+                      AzRgf_forDelta *for_delta) /* updated */
+                      const; 
 }; 
 
 #endif 
@@ -68,6 +68,11 @@ public:
   virtual const AzDvect *weights() const = 0; 
   virtual double constant() const = 0; 
   virtual void printHelp(AzHelp &h) const = 0; 
+  virtual AzInt64 memSize() const { return 0; } /* bytes of the work area */
+
+  /*---  for optimizers that may update only some of the weights  ---*/
+  virtual void requestFullPass() {} /* the next optimize() must go over all */
+  virtual bool wasPartial() const { return false; } /* the last optimize() didn't */
 }; 
 
 #endif 
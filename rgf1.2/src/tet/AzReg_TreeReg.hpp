@@ -48,12 +48,77 @@ public:
   }
 }; 
 
+//! Tree structure and leaf weights that the state of a regularizer reflects 
+/*-------------------------------------------------------------*/
+/* Used to keep the state for optimization across calls when   */
+/* the tree hasn't changed its shape since the last call.      */
+/*-------------------------------------------------------------*/
+class AzReg_TreeCache {
+protected:
+  AzIIarr iia_le_gt; 
+  AzDvect v_w; /* node weights, kept in sync by changeWeight */
+
+public:
+  void reset() {
+    iia_le_gt.reset(); 
+    v_w.reset(); 
+  }
+  void store(const AzTrTree_ReadOnly *tree) {
+    int node_num = tree->nodeNum(); 
+    iia_le_gt.reset(); 
+    iia_le_gt.prepare(node_num); 
+    v_w.reform(node_num); 
+    int nx; 
+    for (nx = 0; nx < node_num; ++nx) {
+      const AzTrTreeNode *np = tree->node(nx); 
+      iia_le_gt.put(np->le_nx, np->gt_nx); 
+      v_w.set(nx, np->weight); 
+    }
+  }
+  bool isSameStructure(const AzTrTree_ReadOnly *tree) const {
+    int node_num = tree->nodeNum(); 
+    if (node_num != iia_le_gt.size() || node_num != v_w.rowNum()) {
+      return false; 
+    }
+    int nx; 
+    for (nx = 0; nx < node_num; ++nx) {
+      int le_nx, gt_nx; 
+      iia_le_gt.get(nx, &le_nx, &gt_nx); 
+      if (tree->node(nx)->le_nx != le_nx || 
+          tree->node(nx)->gt_nx != gt_nx) {
+        return false; 
+      }
+    }
+    return true; 
+  }
+  inline void changeWeight(int nx, double w_diff) {
+    if (v_w.rowNum() > 0) v_w.set(nx, v_w.get(nx)+w_diff); 
+  }
+  /*---  leaves whose weights differ from the stored ones; then store the weights  ---*/
+  void changedLeaves(const AzTrTree_ReadOnly *tree, 
+                     AzIFarr *ifa_nx_diff) /* output */ {
+    int nx; 
+    for (nx = 0; nx < v_w.rowNum(); ++nx) {
+      const AzTrTreeNode *np = tree->node(nx); 
+      if (!np->isLeaf()) continue; 
+      double diff = np->weight - v_w.get(nx); 
+      if (diff != 0) ifa_nx_diff->put(nx, diff); 
+      v_w.set(nx, np->weight); 
+    }
+  }
+}; 
+
 //! Abstract class: interface to tree-structured regularizer 
 class AzReg_TreeReg {
 public:
   virtual void set_shared(AzReg_TreeRegShared *shared) {} 
   virtual void check_reg_depth(const AzRegDepth *) const {}
 
+  /*---  called for every tree before reset() so that reset() of different  ---*/
+  /*---  trees can be done in parallel; prepares what they share            ---*/
+  virtual void prepare(const AzTrTree_ReadOnly *, 
+                       const AzRegDepth *) {}
+
   virtual void reset(const AzTrTree_ReadOnly *inp_tree, 
                      const AzRegDepth *inp_reg_depth) = 0; 
 
@@ -50,12 +50,11 @@ public:
   inline AzReg_TreeReg *reg(int tx) {
     return areg.point_u(tx); 
   }
-  inline AzReg_TreeReg *reg_forNewLeaf(int tx) {
-    int t_num = areg.size(); 
-    if (tx < t_num) return areg.point_u(tx); 
-
+  /*---  node split search is done one tree at a time; a separate object is  ---*/
+  /*---  used so that what reg(tx) keeps for optimization isn't thrown away  ---*/
+  inline AzReg_TreeReg *reg_forNewLeaf(int /* tx */) {
     temporary_reg.copyParam_from(&template_reg); 
-    return &temporary_reg; /* should be root-only tree */
+    return &temporary_reg; 
   }
 }; 
 #endif 
@@ -27,45 +27,6 @@
 
 #define coeff_sum_index 3
 
-/*--------------------------------------------------------*/
-void AzReg_TsrOpt::resetTreeStructure()
-{
-  iia_le_gt.reset(); 
-}
-
-/*--------------------------------------------------------*/
-/* static */
-void AzReg_TsrOpt::storeTreeStructure()
-{
-  iia_le_gt.reset(); 
-  iia_le_gt.prepare(tree->nodeNum()); 
-  int nx; 
-  for (nx = 0; nx < tree->nodeNum(); ++nx) {
-    iia_le_gt.put(tree->node(nx)->le_nx, 
-                  tree->node(nx)->gt_nx); 
-  }
-}
-
-/*--------------------------------------------------------*/
-/* static */
-bool AzReg_TsrOpt::isSameTreeStructure() const
-{
-  if (tree->nodeNum() != iia_le_gt.size()) {
-    return false; 
-  }
-  int nx; 
-  for (nx = 0; nx < tree->nodeNum(); ++nx) {
-    int le_nx, gt_nx; 
-    iia_le_gt.get(nx, &le_nx, &gt_nx); 
-    if (tree->node(nx)->le_nx != le_nx || 
-        tree->node(nx)->gt_nx != gt_nx) {
-      return false; 
-    }
-  }  
-
-  return true; 
-}
-
 /*--------------------------------------------------------*/
 void AzReg_TsrOpt::_reset(const AzTrTree_ReadOnly *inp_tree, 
                           const AzRegDepth *inp_reg_depth)
@@ -77,10 +38,24 @@ void AzReg_TsrOpt::_reset(const AzTrTree_ReadOnly *inp_tree,
     throw new AzException("AzReg_TsrOpt::_reset", "null tree"); 
   }
 
-  bool isSame = isSameTreeStructure(); 
+  bool isSame = cache.isSameStructure(tree); 
 
   forNewLeaf = false; 
+  focus_nx = -1; 
   int node_num = tree->nodeNum(); 
+  if (isSame && v_v.rowNum() == node_num) {
+    /*---  same tree as the last time; apply the changes of leaf weights since then  ---*/
+    AzIFarr ifa_nx_diff; 
+    cache.changedLeaves(tree, &ifa_nx_diff); 
+    int ix; 
+    for (ix = 0; ix < ifa_nx_diff.size(); ++ix) {
+      int nx; 
+      double diff = ifa_nx_diff.get(ix, &nx); 
+      AzReg_Tsrbase::changeWeight(nx, diff); 
+    }
+    return; 
+  }
+
   v_bar.reform(node_num);  
   if (!isSame) {
     /*---  new tree structre  ---*/
@@ -117,12 +92,11 @@ void AzReg_TsrOpt::_reset(const AzTrTree_ReadOnly *inp_tree,
     v_bar.set(nx, w); 
   }  
 
-  focus_nx = -1; 
   if (!isSame) {
     update_dv(); 
-    storeTreeStructure();   
   }
   update_v(); 
+  cache.store(tree); 
 }
 
 /*--------------------------------------------------------*/
@@ -181,7 +155,7 @@ void AzReg_TsrOpt::_reset_forNewLeaf(const AzTrTree_ReadOnly *inp_tree,
   forNewLeaf = false; 
   focus_nx = -1; 
   reg_depth = inp_reg_depth; 
-  resetTreeStructure(); 
+  cache.reset(); 
   reset_v_dv(); 
   
   int node_num = tree->nodeNum(); 
@@ -207,7 +181,7 @@ double AzReg_TsrOpt::_reset_forNewLeaf(int inp_focus_nx,
   forNewLeaf = true; 
   focus_nx = inp_focus_nx; 
   reg_depth = inp_reg_depth; 
-  resetTreeStructure(); 
+  cache.reset(); 
   reset_v_dv(); 
   
   int node_num = tree->nodeNum(); 
@@ -32,8 +32,8 @@ protected:
   AzDmat *m_coeff; /* shared with the regularizers for other trees */
                    /* owned by AzReg_TreeRegShared */
 
-  //! tree structure 
-  AzIIarr iia_le_gt; 
+  //! tree structure and leaf weights that v reflects 
+  AzReg_TreeCache cache; 
 
 public:
   AzReg_TsrOpt() : reg_ite_num(reg_ite_num_dflt), curr_penalty(0), m_coeff(NULL) {}
@@ -50,6 +50,14 @@ public:
     if (rd == NULL) return; 
     rd->check_if_nonincreasing("min-penalty regularizers"); 
   }
+  virtual void prepare(const AzTrTree_ReadOnly *inp_tree, 
+                       const AzRegDepth *inp_reg_depth) {
+    setCoeff(inp_reg_depth, inp_tree, m_coeff); 
+  }
+  virtual void changeWeight(int nx, double w_diff) {
+    AzReg_Tsrbase::changeWeight(nx, w_diff); 
+    cache.changeWeight(nx, w_diff); 
+  }
 
   /*---------------------------------------------------------*/
   virtual void _reset(const AzTrTree_ReadOnly *inp_tree, 
@@ -118,10 +126,6 @@ public:
                        AzDmat *m_coeff); 
 
 protected:
-  void resetTreeStructure(); 
-  bool isSameTreeStructure() const; 
-  void storeTreeStructure(); 
-
   void update_v(); 
   void update_dv(); 
   void reset_v_dv() {
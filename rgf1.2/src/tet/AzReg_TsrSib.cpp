@@ -32,6 +32,7 @@ void AzReg_TsrSib::changeWeight(int nx, double w_diff)
 {
   if (w_diff != 0) {
     v_v.add(av_dv.point(nx), w_diff); 
+    cache.changeWeight(nx, w_diff); 
   }
 }
 
@@ -98,6 +99,21 @@ void AzReg_TsrSib::reset(const AzTrTree_ReadOnly *inp_tree,
   }
 
   int node_num = tree->nodeNum(); 
+  if (cache.isSameStructure(tree) && 
+      v_v.rowNum() == node_num && av_dv.size() == node_num) {
+    /*---  same tree as the last time; apply the changes of leaf weights since then  ---*/
+    AzIFarr ifa_nx_diff; 
+    cache.changedLeaves(tree, &ifa_nx_diff); 
+    int ix; 
+    for (ix = 0; ix < ifa_nx_diff.size(); ++ix) {
+      int nx; 
+      double diff = ifa_nx_diff.get(ix, &nx); 
+      v_v.add(av_dv.point(nx), diff); 
+    }
+    reset_values(); 
+    return; 
+  }
+
   av_dv.reset(node_num);  
   v_v.reform(node_num);  
  
@@ -107,6 +123,7 @@ void AzReg_TsrSib::reset(const AzTrTree_ReadOnly *inp_tree,
 
     deriv_v(tree, nx, false, av_dv.point_u(nx), &v_v); 
   }
+  cache.store(tree); 
   reset_values(); 
 }
 
@@ -119,6 +136,7 @@ void AzReg_TsrSib::reset_forNewLeaf(const AzTrTree_ReadOnly *inp_tree,
   forNewLeaf = true; 
   focus_nx = -1; 
   reg_depth = inp_reg_depth; 
+  cache.reset(); 
 
   int node_num = tree->nodeNum(); 
 
@@ -143,6 +161,7 @@ void AzReg_TsrSib::reset_forNewLeaf(int inp_focus_nx,
   forNewLeaf = true; 
   focus_nx = inp_focus_nx; 
   reg_depth = inp_reg_depth; 
+  cache.reset(); 
 
   int node_num = tree->nodeNum(); 
 
@@ -36,6 +36,7 @@ protected:
 
   AzDataArray<AzSvect> av_dv; 
   AzDvect v_v; 
+  AzReg_TreeCache cache; /* tree structure and leaf weights that v_v reflects */
 
   double vdv_sum, dv2_sum, dr, ddr; 
   double newleaf_dep_factor; 
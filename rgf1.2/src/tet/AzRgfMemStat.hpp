@@ -0,0 +1,116 @@
+/* * * * *
+ *  AzRgfMemStat.hpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_RGF_MEM_STAT_HPP_
+#define _AZ_RGF_MEM_STAT_HPP_
+
+#include "AzUtil.hpp"
+#include "AzPrint.hpp"
+
+/*---  bytes held by the major consumers, and their peak in each phase  ---*/
+class AzRgfMemStat {
+public:
+  enum {
+    cat_data = 0,   /* transposed training data and its sorted arrays */
+    cat_sorted = 1, /* sorted arrays of the tree nodes */
+    cat_split = 2,  /* split assessments kept by the trees */
+    cat_trees = 3,  /* tree nodes and data indexes */
+    cat_opt = 4,    /* work area of the weight optimizer */
+    cat_test = 5,   /* test data and its leaf-membership matrix */
+    cat_num = 6,
+  }; 
+  enum {
+    ph_init = 0,
+    ph_search = 1,
+    ph_optimize = 2,
+    ph_test = 3,
+    ph_num = 4,
+  }; 
+
+protected:
+  AzInt64 cur[cat_num]; 
+  AzInt64 peak[ph_num]; 
+  AzInt64 peak_cat[ph_num][cat_num]; /* breakdown at the peak */
+  AzInt64 cur_disk, peak_disk;  /* temp_for_trees on disk */
+
+public:
+  AzRgfMemStat() { reset(); }
+  void reset() {
+    int cx, px; 
+    for (cx = 0; cx < cat_num; ++cx) cur[cx] = 0; 
+    for (px = 0; px < ph_num; ++px) {
+      peak[px] = 0; 
+      for (cx = 0; cx < cat_num; ++cx) peak_cat[px][cx] = 0; 
+    }
+    cur_disk = peak_disk = 0; 
+  }
+  inline void set(int cat, AzInt64 bytes) {
+    cur[cat] = bytes; 
+  }
+  inline void setDisk(AzInt64 bytes) {
+    cur_disk = bytes; 
+    peak_disk = MAX(peak_disk, bytes); 
+  }
+  inline AzInt64 total() const {
+    AzInt64 size = 0; 
+    int cx; 
+    for (cx = 0; cx < cat_num; ++cx) size += cur[cx]; 
+    return size; 
+  }
+  inline AzInt64 get(int cat) const {
+    return cur[cat]; 
+  }
+
+  /*---  call after updating the categories  ---*/
+  void sample(int phase) {
+    AzInt64 size = total(); 
+    if (size <= peak[phase]) return; 
+    peak[phase] = size; 
+    int cx; 
+    for (cx = 0; cx < cat_num; ++cx) peak_cat[phase][cx] = cur[cx]; 
+  }
+
+  void show(const AzOut &out) const {
+    if (out.isNull()) return; 
+    static const char *ph_name[ph_num] = {"init","search","optimize","test"}; 
+    static const char *cat_name[cat_num] = {"data","sorted","split","trees","opt","test"}; 
+    int px; 
+    for (px = 0; px < ph_num; ++px) {
+      if (peak[px] <= 0) continue; 
+      AzPrint o(out); 
+      o.printBegin("Memory peak (MB)", ", ", "="); 
+      o.print_cont("phase=", ph_name[px]); 
+      o.print("total", toMB(peak[px]), 4); 
+      int cx; 
+      for (cx = 0; cx < cat_num; ++cx) {
+        if (peak_cat[px][cx] > 0) o.print(cat_name[cx], toMB(peak_cat[px][cx]), 4); 
+      }
+      o.printEnd(); 
+    }
+    if (peak_disk > 0) {
+      AzBytArr s("Disk peak (MB): temp_for_trees="); s.cn(toMB(peak_disk), 4); 
+      AzPrint::writeln(out, s); 
+    }
+  }
+
+protected:
+  static inline double toMB(AzInt64 bytes) {
+    return (double)bytes/(double)(1024*1024); 
+  }
+}; 
+#endif
@@ -70,7 +70,7 @@ void AzRgfTree::removeSplitAssessment()
   if (split != NULL) {
     int nx; 
     for (nx = 0; nx < nodes_used; ++nx) {
-      delete split[nx]; split[nx] = NULL; 
+      pool_split.put(split[nx]); split[nx] = NULL; 
     }
   }
 }
@@ -104,7 +104,7 @@ void AzRgfTree::resetWeights()
 /*--------------------------------------------------------*/
 void AzRgfTree::storeDataIndexes()
 {
-  if (!wk.canStore()) return; 
+  if (!wk.canStore() && !doPackDxs) return; 
   if (wk.isStored()) {
     if (wk.node_num != nodes_used) {
       throw new AzException("AzRgfTree::storeDataIndexes", "conflict in #node"); 
@@ -112,6 +112,14 @@ void AzRgfTree::storeDataIndexes()
     return; 
   }
 
+  if (!wk.canStore()) {
+    /*---  no file; compress in memory  ---*/
+    sortLeafDataIndexes(); /* so that deltas become small */
+    wk.set_packed(&ia_root_dx, nodes_used);
+    releaseDataIndexes(); 
+    return; 
+  }
+
   AzIntArr ia_dxs_num; 
   int nx; 
   for (nx = 0; nx < nodes_used; ++nx) {
@@ -122,11 +130,23 @@ void AzRgfTree::storeDataIndexes()
   wk.file->open("ab"); 
 #endif 
 
-  int fsize = wk.file->size(); 
-  wk.set(fsize, nodes_used); 
+  AzInt64 fsize = wk.file->size(); 
   wk.file->seek(fsize); 
-  ia_root_dx.write(wk.file); 
+  AzInt64 len = (AzInt64)sizeof(int)*(2+ia_dxs_num.size()); 
+  if (doPackDxs) {
+    /*---  int_num, byte_num, bytes (block delta + bit-packing)  ---*/
+    sortLeafDataIndexes(); /* so that deltas become small */
+    AzPackedIntArr packed(ia_root_dx.point(), ia_root_dx.size()); 
+    packed.write(wk.file); 
+    len += sizeof(int) + packed.byteNum(); 
+  }
+  else {
+    ia_root_dx.write(wk.file); 
+    len += (AzInt64)sizeof(int)*ia_root_dx.size(); 
+  }
   ia_dxs_num.write(wk.file); 
+  wk.set(fsize, len, nodes_used, doPackDxs); 
+  wk.file->flush(); /* so that it can be mapped or prefetched */
 
 #if 0 
   wk.file->close(true); 
@@ -136,9 +156,9 @@ void AzRgfTree::storeDataIndexes()
 }
 
 /*--------------------------------------------------------*/
-int AzRgfTree::estimateSizeofDataIndexes(int data_num) const
+AzInt64 AzRgfTree::estimateSizeofDataIndexes(int data_num) const
 {
-  return (data_num+1) * sizeof(int) * 2; 
+  return ((AzInt64)data_num+1) * sizeof(int) * 2; 
 }
 
 /*--------------------------------------------------------*/
@@ -151,6 +171,16 @@ void AzRgfTree::releaseDataIndexes()
   for (nx = 0; nx < nodes_used; ++nx) {
     nodes[nx].reset_data_indexes(NULL); 
   }
+  wk.map.unmap(); 
+}
+
+/*--------------------------------------------------------*/
+/* Let the OS read the stored data indexes ahead while other trees */
+/* are processed; restoreDataIndexes() then finds them in memory.  */
+void AzRgfTree::prefetchDataIndexes()
+{
+  if (!wk.isStored() || wk.isPacked) return; 
+  AzMmap::prefetch(wk.file, wk.offset, wk.len); 
 }
 
 /*--------------------------------------------------------*/
@@ -159,9 +189,24 @@ void AzRgfTree::restoreDataIndexes()
   if (!wk.isStored()) return; 
 
   const char *eyec = "AzRgfTree::restoreDataIndexes"; 
-  if (ia_root_dx.size() > 0) {
+  if (ia_root_dx.size() > 0 || wk.map.isMapped()) {
     throw new AzException(eyec, "no need to restore?!"); 
   }
+  if (wk.isPacked) {
+    if (wk.node_num != nodes_used) {
+      throw new AzException(eyec, "conflict in #node"); 
+    }
+    wk.packed.unpack(&ia_root_dx); 
+    _setDataIndexes(NULL, eyec); 
+    return; 
+  }
+
+  if (wk.isFilePacked) {
+    _restorePackedFile(eyec); 
+    return; 
+  }
+  if (_mapDataIndexes(eyec)) return; 
+
   AzIntArr ia_dxs_num; 
 #if 0 
   wk.file->open("rb"); 
@@ -172,20 +217,116 @@ void AzRgfTree::restoreDataIndexes()
 #if 0 
   wk.file->close(); 
 #endif 
-  if (ia_dxs_num.size() != nodes_used) {
-    throw new AzException(eyec, "conflict in #node"); 
+  _setDataIndexes(&ia_dxs_num, eyec); 
+}
+
+/*--------------------------------------------------------*/
+/* Point the nodes directly into the mapped file instead of reading. */
+/* Not possible if byte-swapping is needed (the file is little-     */
+/* endian) or mmap is unavailable; the caller reads then.           */
+bool AzRgfTree::_mapDataIndexes(const char *eyec)
+{
+  if (isSwapNeeded || wk.len <= 0) return false; 
+  if (!wk.map.map(wk.file, wk.offset, wk.len)) return false; 
+
+  /*---  int root_num, root_dxs[root_num], int node_num, dxs_num[node_num]  ---*/
+  const int *ptr = (const int *)wk.map.point(); 
+  AzInt64 int_num = wk.len / sizeof(int); 
+  int root_num = ptr[0]; 
+  if (root_num < 0 || 2+(AzInt64)root_num+nodes_used != int_num || 
+      ptr[1+root_num] != nodes_used) {
+    throw new AzException(eyec, "conflict in the stored data indexes"); 
+  }
+  _setDataIndexes(ptr+1, root_num, ptr+2+root_num, eyec); 
+  return true; 
+}
+
+/*--------------------------------------------------------*/
+/* Compressed in the file: decode straight from the mapping if possible. */
+void AzRgfTree::_restorePackedFile(const char *eyec)
+{
+  AzIntArr ia_dxs_num; 
+  if (!isSwapNeeded && wk.map.map(wk.file, wk.offset, wk.len)) {
+    /*---  int int_num, int byte_num, bytes[byte_num], int node_num, dxs_num[node_num]  ---*/
+    const AzByte *ptr = wk.map.point(); 
+    int hdr[2]; 
+    memcpy(hdr, ptr, sizeof(hdr)); 
+    int int_num = hdr[0], byte_num = hdr[1]; 
+    if (int_num < 0 || byte_num < 0 || 
+        (AzInt64)sizeof(int)*(3+nodes_used) + byte_num != wk.len) {
+      throw new AzException(eyec, "conflict in the stored data indexes"); 
+    }
+    const AzByte *ptr_nodes = ptr + sizeof(hdr) + byte_num; 
+    int node_num; 
+    memcpy(&node_num, ptr_nodes, sizeof(node_num)); 
+    if (node_num != nodes_used) {
+      throw new AzException(eyec, "conflict in #node"); 
+    }
+    ia_root_dx.reset(int_num, 0); 
+    if (int_num > 0) {
+      AzPackedIntArr::unpack(ptr + sizeof(hdr), byte_num, int_num, ia_root_dx.point_u()); 
+    }
+    ia_dxs_num.reset(nodes_used, 0); 
+    if (nodes_used > 0) {
+      memcpy(ia_dxs_num.point_u(), ptr_nodes + sizeof(node_num), sizeof(int)*nodes_used); 
+    }
+    wk.map.unmap(); /* decoded; no longer needed */
   }
-  const int *dxs_num = ia_dxs_num.point(); 
+  else {
+    wk.file->seek(wk.offset); 
+    AzPackedIntArr packed; 
+    packed.read(wk.file); 
+    packed.unpack(&ia_root_dx); 
+    ia_dxs_num.read(wk.file); 
+  }
+  _setDataIndexes(&ia_dxs_num, eyec); 
+}
+
+/*--------------------------------------------------------*/
+void AzRgfTree::_setDataIndexes(const AzIntArr *ia_dxs_num, /* may be NULL */
+                                const char *eyec)
+{
+  const int *dxs_num = NULL; 
+  if (ia_dxs_num != NULL) {
+    if (ia_dxs_num->size() != nodes_used) {
+      throw new AzException(eyec, "conflict in #node"); 
+    }
+    dxs_num = ia_dxs_num->point(); 
+  }
+  _setDataIndexes(ia_root_dx.point(), ia_root_dx.size(), dxs_num, eyec); 
+}
+
+/*--------------------------------------------------------*/
+void AzRgfTree::_setDataIndexes(const int *root_dxs, int root_num, 
+                                const int *dxs_num, /* may be NULL */
+                                const char *eyec)
+{
   int nx; 
   for (nx = 0; nx < nodes_used; ++nx) {
-    if (nodes[nx].dxs_num != dxs_num[nx]) {
+    if (dxs_num != NULL && nodes[nx].dxs_num != dxs_num[nx]) {
       throw new AzException(eyec, "conflict in #data"); 
     }
-    if (nodes[nx].dxs_offset+nodes[nx].dxs_num > ia_root_dx.size()) {
+    if (nodes[nx].dxs_offset+nodes[nx].dxs_num > root_num) {
       throw new AzException(eyec, "conflict in offset"); 
     }
-    nodes[nx].reset_data_indexes(ia_root_dx.point() + nodes[nx].dxs_offset); 
+    nodes[nx].reset_data_indexes(root_dxs + nodes[nx].dxs_offset); 
+
+  }
+}
 
+/*--------------------------------------------------------*/
+/* Order within a leaf doesn't matter once the tree is no longer searched. */
+/* Internal nodes remain contiguous since they are unions of leaves.       */
+void AzRgfTree::sortLeafDataIndexes()
+{
+  int *root_dxs = ia_root_dx.point_u(); 
+  int nx; 
+  for (nx = 0; nx < nodes_used; ++nx) {
+    if (!nodes[nx].isLeaf() || nodes[nx].dxs_num <= 1) continue; 
+    int *dxs = root_dxs + nodes[nx].dxs_offset; 
+    AzIntArr ia_dxs(dxs, nodes[nx].dxs_num); 
+    ia_dxs.sort(true); 
+    memcpy(dxs, ia_dxs.point(), sizeof(int)*ia_dxs.size()); 
   }
 }
 
@@ -199,6 +340,7 @@ void AzRgfTree::resetParam(AzParam &p)
 
   p.swOn(&doUseInternalNodes, kw_doUseInternalNodes); 
   p.swOn(&beVerbose, kw_tree_beVerbose); 
+  p.swOn(&doPackDxs, kw_doPackDxs); 
 
   if (!beVerbose) {
     my_dmp_out.deactivate(); 
@@ -221,6 +363,7 @@ void AzRgfTree::printParam(const AzOut &out) const
   o.printV(kw_max_leaf_num, max_leaf_num); 
   o.printSw(kw_doUseInternalNodes, doUseInternalNodes); 
   o.printSw(kw_tree_beVerbose, beVerbose); 
+  o.printSw(kw_doPackDxs, doPackDxs); 
   o.ppEnd(); 
 }
 
@@ -233,5 +376,6 @@ void AzRgfTree::printHelp(AzHelp &h) const
   h.item_experimental(kw_max_leaf_num, help_max_leaf_num, "-1: Don't care"); 
   h.item_experimental(kw_doUseInternalNodes, help_doUseInternalNodes); 
   h.item_experimental(kw_tree_beVerbose, help_tree_beVerbose); 
+  h.item_experimental(kw_doPackDxs, help_doPackDxs); 
   h.end(); 
 }
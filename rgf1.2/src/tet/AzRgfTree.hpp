@@ -25,30 +25,49 @@
 #include "AzTrTtarget.hpp"
 #include "AzRgf_FindSplit.hpp"
 #include "AzParam.hpp"
+#include "AzPackedIntArr.hpp"
+#include "AzMmap.hpp"
 
 class AzRgfTreeTemp {
 public:
   AzFile *file;  
-  int offset; 
+  AzInt64 offset, len; 
   int node_num; 
-  AzRgfTreeTemp() : offset(-1), node_num(0), file(NULL) {}
+  AzPackedIntArr packed; /* used instead of file if file is NULL */
+  bool isPacked; 
+  bool isFilePacked; /* compressed in the file */
+  AzMmap map; /* restored data indexes point into this if mapped */
+  AzRgfTreeTemp() : file(NULL), offset(-1), len(0), node_num(0), isPacked(false), 
+                    isFilePacked(false) {}
   inline void reset(AzFile *inp_file) {
+    map.unmap(); 
     file = inp_file; 
     offset = -1; 
+    len = 0; 
     node_num = 0; 
+    packed.reset(); 
+    isPacked = isFilePacked = false; 
   }
   inline bool canStore() {
     if (file == NULL) return false; 
     return true; 
   }
   inline bool isStored() {
-    if (offset >= 0) {
+    if (offset >= 0 || isPacked) {
       return true; 
     }
     return false; 
   }
-  void set(int inp_offset, int inp_node_num) {
+  void set(AzInt64 inp_offset, AzInt64 inp_len, int inp_node_num, 
+           bool inp_isFilePacked) {
     offset = inp_offset; 
+    len = inp_len; 
+    node_num = inp_node_num; 
+    isFilePacked = inp_isFilePacked; 
+  }
+  void set_packed(const AzIntArr *ia_dx, int inp_node_num) {
+    packed.pack(ia_dx); 
+    isPacked = true; 
     node_num = inp_node_num; 
   }
 };
@@ -62,6 +81,7 @@ protected:
   bool doUseInternalNodes; 
   AzOut out, my_dmp_out; 
   bool beVerbose; 
+  bool doPackDxs; 
 
   AzRgfTreeTemp wk; 
 
@@ -70,12 +90,12 @@ protected:
 public:
   AzRgfTree() 
     : max_depth(-1), max_leaf_num(-1), min_size(min_size_dflt), 
-	doUseInternalNodes(false), beVerbose(false), 
-      my_dmp_out(dmp_out) {}
+	doUseInternalNodes(false), 
+      my_dmp_out(dmp_out), beVerbose(false), doPackDxs(false) {}
   AzRgfTree(AzParam &param) 
     : max_depth(-1), max_leaf_num(-1), min_size(min_size_dflt), 
-	doUseInternalNodes(false), beVerbose(false), 
-      my_dmp_out(dmp_out) {
+	doUseInternalNodes(false), 
+      my_dmp_out(dmp_out), beVerbose(false), doPackDxs(false) {
     resetParam(param); 
   }
 
@@ -91,10 +111,21 @@ public:
   virtual void forStoringDataIndexes(AzFile *file) {
     wk.reset(file); 
   }
+  /*---  compress in memory even if not requested by parameter  ---*/
+  virtual void forCompressingDataIndexes() {
+    doPackDxs = true; 
+  }
+  virtual AzInt64 memSize() const {
+    return AzTrTree::memSize() + wk.packed.byteNum(); 
+  }
   virtual void storeDataIndexes(); 
   virtual void releaseDataIndexes(); 
   virtual void restoreDataIndexes(); 
-  virtual int estimateSizeofDataIndexes(int data_num) const; 
+  virtual void prefetchDataIndexes(); /* start reading in the background */
+  virtual AzInt64 estimateSizeofDataIndexes(int data_num) const; 
+  virtual bool isCompressingDataIndexes() const {
+    return doPackDxs; 
+  }
 
   /*---  ---*/
   virtual void resetParam(AzParam &param); 
@@ -173,7 +204,7 @@ protected:
     if (doRefreshAll || 
         split[nx] == NULL || 
         nx == root_nx) {
-      if (split[nx] == NULL) split[nx] = new AzTrTsplit(); 
+      if (split[nx] == NULL) split[nx] = pool_split.get(); 
       else                   split[nx]->reset();
       fs->findSplit(nx, split[nx]); 
     }
@@ -183,6 +214,13 @@ protected:
   }
 
   virtual void adjustParam(); 
+  void sortLeafDataIndexes(); 
+  void _setDataIndexes(const AzIntArr *ia_dxs_num, const char *eyec); 
+  void _setDataIndexes(const int *root_dxs, int root_num, 
+                       const int *dxs_num, /* may be NULL */
+                       const char *eyec); 
+  bool _mapDataIndexes(const char *eyec); 
+  void _restorePackedFile(const char *eyec); 
 }; 
 
 #endif 
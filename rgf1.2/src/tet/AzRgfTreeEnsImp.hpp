@@ -61,6 +61,12 @@ public:
   inline AzRgfTree *tree_u(int tx) const {
     return ens.tree_u(tx); 
   }
+  inline void forceCompressingDataIndexes(bool inp) {
+    ens.forceCompressingDataIndexes(inp); 
+  }
+  inline AzInt64 tempFileSize() {
+    return ens.tempFileSize(); 
+  }
 
   inline T *rawtree_u(int tx) const {
     return ens.tree_u(tx); 
@@ -39,6 +39,8 @@ public:
   virtual bool isFull() const = 0; 
 
   virtual void copy_nodes_from(const AzTrTreeEnsemble_ReadOnly *inp) = 0; 
+  virtual void forceCompressingDataIndexes(bool inp) = 0; 
+  virtual AzInt64 tempFileSize() = 0; 
   virtual void printHelp(AzHelp &h) const = 0; 
 
   virtual void cold_start(AzParam &param, 
@@ -86,6 +86,14 @@ public:
                           int *f_num, int *nz_f_num) const = 0; 
 
   virtual void printHelp(AzHelp &h) const = 0; 
+
+  /*! bytes used for optimization */
+  virtual AzInt64 memSize() const { return 0; }
+
+  /*! the next update must go over all the weights */
+  virtual void requestFullPass() {}
+  /*! true if the last update didn't go over all the weights */
+  virtual bool wasPartial() const { return false; }
 }; 
 #endif 
 
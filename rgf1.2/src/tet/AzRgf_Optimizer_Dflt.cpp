@@ -76,7 +76,7 @@ AzRgf_Optimizer_Dflt::update(const AzDataForTrTree *data,
   AzIntArr ia_removed_fx; 
   int f_num_delta = feat1.update_with_ens(ens, &ia_removed_fx); 
 
-  if (f_num_delta > 0 || ens->size() == 0) {
+  if (f_num_delta > 0 || ens->size() == 0 || trainer->wasPartial()) {
     trainer->optimize(ens, &feat1); 
   }
   else {
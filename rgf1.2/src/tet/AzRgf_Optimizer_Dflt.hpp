@@ -69,12 +69,22 @@ public:
                           AzBmat *temp_b, AzDvect *v_test_p, 
                           int *f_num, int *nz_f_num) const {   
     AzRgf_Optimizer_Dflt temp_opt(this);   
+    temp_opt.requestFullPass(); 
     temp_opt.update(tr_data, temp_ens); 
     if (test_data != NULL) temp_opt.apply(test_data, temp_b, temp_ens, 
                                           v_test_p, f_num, nz_f_num); 
   }
   /*--------------------------------------------------------*/
 
+  virtual AzInt64 memSize() const {
+    return trainer->memSize(); 
+  }
+  virtual void requestFullPass() {
+    trainer->requestFullPass(); 
+  }
+  virtual bool wasPartial() const {
+    return trainer->wasPartial(); 
+  }
 
   virtual void cold_start(AzLossType loss_type, 
              const AzDataForTrTree *data, 
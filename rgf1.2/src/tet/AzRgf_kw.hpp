@@ -40,6 +40,10 @@
 #define kw_f_ratio "f_ratio="
 #define kw_random_seed "random_seed="
 #define kw_doPassiveRoot "PassiveRoot"
+#define kw_doQuantize "QuantizeTarget"
+#define kw_quant_tol "quantize_tol="
+#define kw_max_sorted_mem "max_sorted_mem="
+#define kw_max_memory "max_memory="
 
 #define help_loss           "Loss function"
 #define help_max_tree_num   "Stop training when the number of trees exceeds this number."
@@ -57,6 +61,10 @@
 #define help_f_ratio "For feature sampling."
 #define help_random_seed "Random seed."
 #define help_doPassiveRoot "Consider to split the root (to start a new tree) only if there is no other choice."
+#define help_doQuantize "For speed, use 16-bit copies of the gradient statistics (with stochastic rounding) in node search."
+#define help_quant_tol "Used with QuantizeTarget.  Use the exact values instead if the quantization step exceeds this ratio of the average magnitude."
+#define help_max_memory "Memory budget in megabytes.  If the training data and the sorted arrays of the trees are not expected to fit, Conservative memory policy, a bound on the sorted arrays of the trees, and compression of the data indexes of the trees are turned on accordingly.  The peak usage in each phase is shown at the end of training.  0: no budget."
+#define help_max_sorted_mem "Upper bound (in megabytes) of the memory for the sorted feature values kept for the trees being searched.  When exceeded, those of the least recently grown trees are released and rebuilt from the training data when needed.  0: no limit."
 
 /*--- AzRgforest_Sim ---*/
 #define kw_s "shrink="
@@ -68,12 +76,14 @@
 #define kw_max_leaf_num       "max_leaf_tree=" 
 #define kw_doUseInternalNodes "UseInternalNodes" 
 #define kw_tree_beVerbose     "Verbose_tree"
+#define kw_doPackDxs          "CompressDataIndexes"
 
 #define help_max_depth          "Maximum node depth of the trees."
 #define help_min_size           "Minimum number of training data points in each leaf node." 
 #define help_max_leaf_num       "Tree size.  Maximum number of the number of leaf nodes in the tree." 
 #define help_doUseInternalNodes "Assign weights to internal nodes as well as leaf nodes." 
 #define help_tree_beVerbose     "Print tree-level information."
+#define help_doPackDxs          "To reduce memory consumption, keep the data indexes of the trees that are no longer searched in compressed form in memory.  If temp_disk is specified, they are written to the temporary files in compressed form instead."
 
 /*--- AzRgfTree_Sim ---*/
 #define kw_doWidthFirst    "WidthFirst"
@@ -91,6 +101,14 @@
 #define kw_opt_beVerbose "Verbose_opt"
 #define kw_not_doIntercept "DontUseIntercept"
 #define kw_doIntercept     "UseIntercept"
+#define kw_doOptByTree "OptimizeByTree"
+#define kw_doOptParallel "OptimizeParallel"
+#define kw_opt_shotgun "opt_shotgun_trees="
+#define kw_opt_active_full "opt_active_full="
+#define kw_opt_active_stall "opt_active_stall="
+#define kw_opt_block_newton "opt_block_newton="
+#define kw_doOptLBFGS "OptimizeLBFGS"
+#define kw_opt_lbfgs_mem "opt_lbfgs_memory="
 
 #define help_lambda "lambda.  Regularization coefficient."        
 #define help_sigma  "L1 regularization coefficient." 
@@ -105,6 +123,14 @@
 #define help_opt_beVerbose "Print information on weight optimization."
 #define help_not_doIntercept "Do not include intercept in the weight optimization."
 #define help_doIntercept     "Include intercept in the weight optimization."
+#define help_doOptByTree "Update the weights of all the leaves of a tree at once by streaming over a per-tree leaf-id vector (2 bytes per data point per tree) instead of going through the data indexes of each leaf.  Not for min-penalty regularization."
+#define help_doOptParallel "Update the weights of the leaves of a tree in parallel (multi-threaded).  The leaves of a tree don't share data points, so the result is the same as the sequential update except for the order of summation in the loss derivatives, which is fixed independent of the number of threads.  With min-penalty regularization, the trees are updated in parallel, each tree leaf by leaf."
+#define help_opt_active_full "If positive, optimize only the leaves added since the previous weight optimization, and go over all the leaves every this many optimizations, before testing, and at the end of training.  0: always go over all the leaves.  Not for min-penalty regularization."
+#define help_opt_active_stall "With opt_active_full, go over all the leaves when the optimization of the new leaves reduces the training loss by less than this ratio."
+#define help_opt_block_newton "With OptimizeByTree, take up to this many Newton steps on the leaves of a tree before going to the next tree.  The predictions are updated once per tree, and with square loss the extra steps need no pass over the data.  Not for min-penalty regularization."
+#define help_doOptLBFGS "Optimize the weights of all the leaves at once by L-BFGS (OWL-QN if reg_L1 is positive) instead of coordinate descent; each iteration goes over the data indexes of all the trees twice.  max_delta is ignored.  Not for min-penalty regularization, OptimizeByTree, or opt_active_full."
+#define help_opt_lbfgs_mem "With OptimizeLBFGS, the number of past steps kept for approximating the Hessian."
+#define help_opt_shotgun "With OptimizeParallel, update the leaves of this many trees at once from the same predictions (shotgun-style; approximate when greater than 1)."
 
 /*--- AzRgf_FindSplit_Dflt ---*/
 /* #define kw_lambda "reg_L2="  shared with opt */
@@ -22,7 +22,7 @@
 
 /*-------------------------------------------------------------------*/
 void AzRgforest::cold_start(const char *param, 
-                        const AzSmat *m_x, 
+                        AzSmat *m_x, /* destroyed */
                         const AzDvect *v_y, 
                         const AzSvFeatInfo *featInfo, 
                         const AzDvect *v_fixed_dw, 
@@ -34,6 +34,9 @@ void AzRgforest::cold_start(const char *param,
   AzParam az_param(param); 
   int max_tree_num = resetParam(az_param); 
   setInput(az_param, m_x, featInfo);        
+  mem_stat.reset(); 
+  doCompressDxs = false; 
+  if (max_memory > 0) fitInMemory(max_tree_num); 
   reg_depth->reset(az_param, out);  /* init regularizer on node depth */
   v_p.reform(v_y->rowNum()); 
   opt->cold_start(loss_type, data, reg_depth, /* initialize optimizer */
@@ -43,18 +46,20 @@ void AzRgforest::cold_start(const char *param,
   fs->reset(az_param, reg_depth, out); /* initialize node search */
   az_param.check(out); 
   l_num = 0; /* initialize leaf node counter */
+  ia_tree_grown.reset(); 
 
   if (!beVerbose) { 
     out.deactivate(); /* shut up after printing everyone's config */
   }
 
   time_init(); /* initialize time measure ment */
+  sampleMem(AzRgfMemStat::ph_init); 
   end_of_initialization(); 
 }
 
 /*-------------------------------------------------------------------*/
 void AzRgforest::warm_start(const char *param, 
-                        const AzSmat *m_x, 
+                        AzSmat *m_x, /* destroyed */
                         const AzDvect *v_y, 
                         const AzSvFeatInfo *featInfo, 
                         const AzDvect *v_fixed_dw, 
@@ -77,6 +82,9 @@ void AzRgforest::warm_start(const char *param,
   warmup_timer(inp_ens, max_tree_num); /* timers are modified for warm-start */
 
   setInput(az_param, m_x, featInfo); 
+  mem_stat.reset(); 
+  doCompressDxs = false; 
+  if (max_memory > 0) fitInMemory(max_tree_num); 
 
   AzTimeLog::print("Warming-up trees ... ", log_out); 
   warmupEnsemble(az_param, max_tree_num, inp_ens); /* v_p is set */
@@ -93,12 +101,14 @@ void AzRgforest::warm_start(const char *param,
   fs->reset(az_param, reg_depth, out); /* initialize node search */
   az_param.check(out); 
   l_num = ens->leafNum();  /* warm-up #leaf */
+  ia_tree_grown.reset(); 
 
   if (!beVerbose) { 
     out.deactivate(); /* shut up after printing everyone's config */
   }
 
   time_init(); /* initialize time measure ment */
+  sampleMem(AzRgfMemStat::ph_init); 
   end_of_initialization(); 
   AzTimeLog::print("End of warming-up ... ", log_out); 
 }
@@ -133,6 +143,7 @@ void AzRgforest::warmup_timer(const AzTreeEnsemble *inp_ens,
 void AzRgforest::warmupEnsemble(AzParam &az_param, int max_tree_num, 
                                 const AzTreeEnsemble *inp_ens)
 {
+  ens->forceCompressingDataIndexes(doCompressDxs); 
   ens->warm_start(inp_ens, data, az_param, &s_temp_for_trees, 
                   out, max_tree_num, s_tree_num, &v_p); 
 
@@ -154,7 +165,7 @@ void AzRgforest::initTarget(const AzDvect *v_y,
 
 /*-------------------------------------------------------------------*/
 void AzRgforest::setInput(AzParam &p, 
-                          const AzSmat *m_x, 
+                          AzSmat *m_x, /* destroyed */
                           const AzSvFeatInfo *featInfo)
 {
   dflt_data.reset_data(out, m_x, p, beTight, featInfo); 
@@ -168,6 +179,73 @@ void AzRgforest::setInput(AzParam &p,
   }
 }
 
+/*------------------------------------------------------------------*/
+/* Turn on the memory savers as needed to stay within max_memory.   */
+/* Node sorted arrays cost about as much as the data-level ones per */
+/* searched tree, and data indexes take one int per data point per  */
+/* tree unless compressed.                                          */
+void AzRgforest::fitInMemory(int max_tree_num)
+{
+  AzInt64 budget = (AzInt64)max_memory*1024*1024; 
+  AzInt64 data_size = dflt_data.memSize(); 
+  AzInt64 sorted_size = dflt_data.sorted_array()->memSize(); 
+  AzInt64 remain = budget - data_size; 
+  AzBytArr s("max_memory: data uses "); 
+  s.cn((double)data_size/1024/1024, 4); s.c(" MB"); 
+  if (remain <= 0) {
+    s.c("; over the budget already."); 
+    AzPrint::writeln(out, s); 
+    remain = 0; 
+  }
+  else {
+    AzPrint::writeln(out, s); 
+  }
+
+  /*---  sorted arrays of the nodes being searched  ---*/
+  if (!beTight && sorted_size*(s_tree_num+1) > remain/2) {
+    beTight = true; 
+    dflt_data.tighten(); 
+    AzBytArr s("max_memory: turning on "); s.c(kw_mem_policy); s.c(mp_beTight); 
+    AzPrint::writeln(out, s); 
+  }
+  if (max_sorted_mem == 0 && sorted_size*(s_tree_num+1) > remain/4) {
+    max_sorted_mem = (int)MAX(1, remain/4/1024/1024); 
+    AzBytArr s("max_memory: setting "); s.c(kw_max_sorted_mem); s.cn(max_sorted_mem); 
+    AzPrint::writeln(out, s); 
+  }
+
+  /*---  data indexes of the trees  ---*/
+  AzInt64 dxs_size = (AzInt64)max_tree_num*data->dataNum()*(AzInt64)sizeof(int); 
+  if (dxs_size > remain/2 && 
+      s_temp_for_trees.length() <= 0) {
+    doCompressDxs = true; 
+    AzPrint::writeln(out, "max_memory: compressing the data indexes of the trees in memory"); 
+  }
+}
+
+/*------------------------------------------------------------------*/
+void AzRgforest::sampleMem(int phase) const
+{
+  mem_stat.set(AzRgfMemStat::cat_data, data->memSize()); 
+  AzInt64 sorted_size = 0, split_size = 0, tree_size = 0; 
+  int tx; 
+  for (tx = 0; tx < ens->size(); ++tx) {
+    const AzRgfTree *tree = ens->tree_u(tx); 
+    sorted_size += tree->sortedArrSize(); 
+    split_size += tree->splitSize(); 
+    tree_size += tree->memSize(); 
+  }
+  sorted_size += rootonly_tree->sortedArrSize(); 
+  split_size += rootonly_tree->splitSize(); 
+  tree_size += rootonly_tree->memSize(); 
+  mem_stat.set(AzRgfMemStat::cat_sorted, sorted_size); 
+  mem_stat.set(AzRgfMemStat::cat_split, split_size); 
+  mem_stat.set(AzRgfMemStat::cat_trees, tree_size); 
+  mem_stat.set(AzRgfMemStat::cat_opt, opt->memSize()); 
+  mem_stat.setDisk(ens->tempFileSize()); 
+  mem_stat.sample(phase); 
+}
+
 /*------------------------------------------------------------------*/
 void AzRgforest::initEnsemble(AzParam &az_param, int max_tree_num)
 {
@@ -178,6 +256,7 @@ void AzRgforest::initEnsemble(AzParam &az_param, int max_tree_num)
                           "max# must be positive"); 
   }
 
+  ens->forceCompressingDataIndexes(doCompressDxs); 
   ens->cold_start(az_param, &s_temp_for_trees, data->dataNum(), 
                   out, max_tree_num, data->featNum()); 
 
@@ -216,13 +295,14 @@ AzTETrainer_Ret AzRgforest::proceed_until()
     if (doExit) break; 
 
     /*---  optimize weights  ---*/
+    bool doTestNow = test_timer.ringing(false, l_num); 
     if (opt_timer.ringing(false, l_num)) {
+      if (doTestNow) opt->requestFullPass(); 
       optimize_resetTarget(); 
       show_tree_info(); 
     }
 
     /*---  time to test?  ---*/
-    bool doTestNow = test_timer.ringing(false, l_num); 
     if (doTestNow) {  
       ret = AzTETrainer_Ret_TestNow; 
       break; /* time to test */
@@ -230,10 +310,12 @@ AzTETrainer_Ret AzRgforest::proceed_until()
   }
 
   if (ret == AzTETrainer_Ret_Exit) {
-    if (!isOpt) {
+    if (!isOpt || opt->wasPartial()) {
+      opt->requestFullPass(); 
       optimize_resetTarget(); 
     }
     time_show(); 
+    mem_stat.show(log_out); 
     end_of_training(); 
   }
 
@@ -264,6 +346,7 @@ bool AzRgforest::growForest()
   /*---  find the best split  ---*/
   AzTrTsplit best_split; 
   searchBestSplit(&best_split);                    
+  sampleMem(AzRgfMemStat::ph_search); 
   if (shouldExit(&best_split)) { /* exit if no more split */
     return true; /* exit */
   }
@@ -298,6 +381,12 @@ const AzRgfTree *AzRgforest::splitNode(AzTrTsplit *best_split, /* (tx,nx) may be
   double new_w = tree->node(best_split->nx)->weight; 
   isOpt = false; 
 
+  if (max_sorted_mem > 0) { /* for releasing sorted arrays of the least recently grown */
+    int tx = best_split->tx; 
+    for ( ; ia_tree_grown.size() <= tx; ) ia_tree_grown.put(-1); 
+    ia_tree_grown.update(tx, l_num); 
+  }
+
   ++l_num; /* if it wasn't root, one leaf was removed and two leaves were added */
   if (best_split->nx == tree->root()) {
     ++l_num; 
@@ -359,6 +448,7 @@ void AzRgforest::searchBestSplit(AzTrTsplit *best_split) /* must be initialize b
     my_tar.reset(&target);
     my_tar.weight_tarDw(); 
     my_tar.weight_dw(); 
+    my_tar.quantize(); 
     nn = target.sum_fixed_dw(); 
     tar = &my_tar; 
   }
@@ -379,6 +469,41 @@ void AzRgforest::searchBestSplit(AzTrTsplit *best_split) /* must be initialize b
     input.tx = rootonly_tx; 
     rootonly_tree->findSplit(fs, input, doRefreshAll, best_split); 
   }
+
+  if (max_sorted_mem > 0) {
+    limitSortedArrays(my_first, last_tx, best_split->tx); 
+  }
+}
+
+/*------------------------------------------------------------------*/
+/* Release the sorted arrays of the least recently grown trees      */
+/* until the total fits in max_sorted_mem.  They are rebuilt from   */
+/* the training data when the trees are searched again.             */
+void AzRgforest::limitSortedArrays(int first_tx, int last_tx, 
+                                   int keep_tx) /* about to be split */
+{
+  AzInt64 max_size = (AzInt64)max_sorted_mem*1024*1024; 
+  AzInt64 total = 0; 
+  AzIFarr ifa_tx_grown; 
+  int tx; 
+  for (tx = first_tx; tx <= last_tx; ++tx) {
+    AzInt64 size = ens->tree_u(tx)->sortedArrSize(); 
+    total += size; 
+    if (size > 0 && tx != keep_tx) {
+      ifa_tx_grown.put(tx, lastGrown(tx)); 
+    }
+  }
+  if (total <= max_size) return; 
+
+  ifa_tx_grown.sort_FloatInt(true); /* least recently grown first */
+  int ix; 
+  for (ix = 0; ix < ifa_tx_grown.size() && total > max_size; ++ix) {
+    int tx; 
+    ifa_tx_grown.get(ix, &tx); 
+    AzRgfTree *tree = ens->tree_u(tx); 
+    total -= tree->sortedArrSize(); 
+    tree->releaseSortedArrays(); 
+  }
 }
 
 /*------------------------------------------------------------------*/
@@ -428,6 +553,7 @@ void AzRgforest::optimize_resetTarget()
   AzTimeLog::print(s, out); 
 
   opt->update(data, ens, &v_p); 
+  sampleMem(AzRgfMemStat::ph_optimize); 
   resetTarget(); 
 
   int tx; 
@@ -449,8 +575,8 @@ void AzRgforest::_updateTarget_OtherLoss(const AzRgfTree *tree,
   const double *y = target.y()->point(); 
   double *p = v_p.point_u(); 
 
-  double *tar_dw = target.tarDw_forUpdate()->point_u(); 
-  double *dw = target.dw_forUpdate()->point_u(); 
+  AZ_MTX_FLOAT *tar_dw = target.tarDw_forUpdate()->point_u(); 
+  AZ_MTX_FLOAT *dw = target.dw_forUpdate()->point_u(); 
 
   int kx; 
   for (kx = 0; kx < 2; ++kx) {
@@ -465,8 +591,8 @@ void AzRgforest::_updateTarget_OtherLoss(const AzRgfTree *tree,
       p[dx] += (new_w + w_inc); 
 
       AzLosses o = AzLoss::getLosses(loss_type, p[dx], y[dx], py_adjust); 
-      dw[dx] = o.loss2; 
-      tar_dw[dx] = o._loss1;  
+      dw[dx] = (AZ_MTX_FLOAT)o.loss2; 
+      tar_dw[dx] = (AZ_MTX_FLOAT)o._loss1;  
     }
   }
 }
@@ -481,7 +607,7 @@ void AzRgforest::_updateTarget_LS(const AzRgfTree *tree,
                                   AzTrTtarget *target, /* updated */
                                   AzDvect *v_p)        /* updated */
 {
-  double *r = target->tarDw_forUpdate()->point_u(); 
+  AZ_MTX_FLOAT *r = target->tarDw_forUpdate()->point_u(); 
   double *p = v_p->point_u(); 
 
   int kx; 
@@ -510,11 +636,12 @@ void AzRgforest::resetTarget()
 {
   if (loss_type == AzLoss_Square) {
     target.resetTarDw_residual(&v_p); 
+    target.quantize(); 
     return; 
   }
 
-  AzDvect *v_tar_dw = target.tarDw_forUpdate();  /* tar*dw */
-  AzDvect *v_dw = target.dw_forUpdate(); 
+  AzFvect *v_tar_dw = target.tarDw_forUpdate();  /* tar*dw */
+  AzFvect *v_dw = target.dw_forUpdate(); 
 
   /*---  train for -L'/L''  ---*/
   lam_scale = 
@@ -526,11 +653,12 @@ void AzRgforest::resetTarget()
   if (!out.isNull() && AzLoss::isExpoFamily(loss_type)) {
     show_forExpoFamily(v_dw); 
   }
+  target.quantize(); 
 }
 
 /*-------------------------------------------------------------------*/
 /* print to stdout only when Dump is specified */
-void AzRgforest::show_forExpoFamily(const AzDvect *v_dw) const
+void AzRgforest::show_forExpoFamily(const AzFvect *v_dw) const
 {
   if (dmp_out.isNull()) return; 
   if (out.isNull()) return; 
@@ -556,6 +684,8 @@ AzRgforest::apply(AzTETrainer_TestData *td,
   const AzDataForTrTree *test_data = AzTETrainer::_data(td); 
   int f_num = -1, nz_f_num = -1; 
   AzBmat *b_test_tran = AzTETrainer::_b(td); 
+  mem_stat.set(AzRgfMemStat::cat_test, test_data->memSize()+b_test_tran->memSize()); 
+  sampleMem(AzRgfMemStat::ph_test); 
   if (!isOpt) { /* weights have not been corrected */
     AzTimeLog::print("Testing (branch-off for end-of-training optimization)", out); 
     AzBmat temp_b(b_test_tran); 
@@ -694,13 +824,38 @@ int AzRgforest::resetParam(AzParam &p)
   int random_seed = -1; 
   if (f_ratio > 0 && f_ratio < 1) {
     p.vInt(kw_random_seed, &random_seed); 
-    if (srand > 0) {
+    if (random_seed > 0) {
       srand(random_seed); 
     }
   }
 
   p.swOn(&doPassiveRoot, kw_doPassiveRoot); 
 
+  p.vInt(kw_max_sorted_mem, &max_sorted_mem); 
+  if (max_sorted_mem < 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_max_sorted_mem, 
+                          "must be non-negative"); 
+  }
+
+  p.vInt(kw_max_memory, &max_memory); 
+  if (max_memory < 0) {
+    throw new AzException(AzInputNotValid, eyec, kw_max_memory, 
+                          "must be non-negative"); 
+  }
+
+  /*---  16-bit targets for node search  ---*/
+  p.swOn(&doQuantize, kw_doQuantize); 
+  if (doQuantize) {
+    p.vFloat(kw_quant_tol, &quant_tol); 
+    if (quant_tol <= 0) {
+      throw new AzException(AzInputNotValid, eyec, kw_quant_tol, "must be positive"); 
+    }
+    target.set_quantize(quant_tol); 
+  }
+  else {
+    target.set_quantize(-1); 
+  }
+
   /*---  for maintenance purposes  ---*/
   p.swOn(&doForceToRefreshAll, kw_doForceToRefreshAll); 
   p.swOn(&beVerbose, kw_forest_beVerbose); /* for compatibility */
@@ -725,6 +880,12 @@ int AzRgforest::resetParam(AzParam &p)
     o.printV(kw_f_ratio, f_ratio); 
     o.printV(kw_random_seed, random_seed); 
     o.printSw(kw_doPassiveRoot, doPassiveRoot); 
+    o.printV(kw_max_sorted_mem, max_sorted_mem); 
+    o.printV(kw_max_memory, max_memory); 
+    o.printSw(kw_doQuantize, doQuantize); 
+    if (doQuantize) {
+      o.printV(kw_quant_tol, quant_tol); 
+    }
     o.ppEnd(); 
   }
 
@@ -757,6 +918,8 @@ void AzRgforest::printHelp(AzHelp &h) const
   h.item_experimental(kw_temp_for_trees, help_temp_for_trees); 
   h.item_experimental(kw_f_ratio, help_f_ratio); 
   h.item_experimental(kw_doPassiveRoot, help_doPassiveRoot); 
+  h.item_experimental(kw_doQuantize, help_doQuantize); 
+  h.item_experimental(kw_quant_tol, help_quant_tol, quant_tol_dflt); 
   h.end(); 
 
   reg_depth->printHelp(h);  
@@ -767,5 +930,7 @@ void AzRgforest::printHelp(AzHelp &h) const
   h.item(kw_doTime, help_doTime); 
   h.item(kw_beVerbose, help_beVerbose); 
   h.item(kw_mem_policy, help_mem_policy, mp_not_beTight); 
+  h.item_experimental(kw_max_sorted_mem, help_max_sorted_mem, 0); 
+  h.item_experimental(kw_max_memory, help_max_memory, 0); 
   h.end();
 }
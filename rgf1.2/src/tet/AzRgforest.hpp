@@ -34,6 +34,7 @@
 #include "AzRgfTreeEnsImp.hpp"
 #include "AzRegDepth.hpp"
 #include "AzParam.hpp"
+#include "AzRgfMemStat.hpp"
 
 //! RGF main.  
 class AzRgforest : /* implements */ public virtual AzTETrainer {
@@ -71,12 +72,19 @@ protected:
   double f_ratio; 
   int f_pick; 
   bool doPassiveRoot; 
+  bool doQuantize; 
+  double quant_tol; 
+  int max_sorted_mem; /* in MB */
+  int max_memory; /* in MB */
+  bool doCompressDxs; /* set by max_memory */
 
   /*---  work area  ---*/
   int l_num; 
+  AzIntArr ia_tree_grown; /* tx -> l_num when tree[tx] was last grown */
   double py_adjust, lam_scale; /* for numerical stability for exp loss */
   AzDvect v_p; /* prediction */
   AzTimer test_timer, opt_timer, lmax_timer; 
+  mutable AzRgfMemStat mem_stat; 
   AzOut out; 
 
   bool doTime; 
@@ -86,6 +94,7 @@ protected:
   static const int max_lnum_dflt = 10000; 
   static const int lnum_inc_test_dflt = 500; 
   static const int s_tree_num_dflt = 1; 
+  #define quant_tol_dflt 0.01
   static const AzLossType loss_type_dflt = AzLoss_Square; 
 
 public:
@@ -98,7 +107,8 @@ public:
     opt_time(0), search_time(0), doTime(false), 
     beTight(false), s_mem_policy(mp_not_beTight), 
     f_ratio(-1), f_pick(-1), 
-    doPassiveRoot(false) 
+    doPassiveRoot(false), doQuantize(false), quant_tol(quant_tol_dflt), 
+    max_sorted_mem(0), max_memory(0), doCompressDxs(false) 
   {
     opt = &dflt_opt; 
     ens = &dflt_ens; 
@@ -169,7 +179,7 @@ protected:
   /*----------------------------------------------------------------*/
 
   virtual void setInput(AzParam &p, 
-                        const AzSmat *m_x, 
+                        AzSmat *m_x, /* destroyed */
                         const AzSvFeatInfo *featInfo); 
   virtual void initEnsemble(AzParam &param, int max_tree_num); 
 
@@ -201,6 +211,13 @@ protected:
     else {
      _updateTarget_OtherLoss(tree, leaf_nx, w_inc); 
     }
+    if (doQuantize) {
+      int kx; 
+      for (kx = 0; kx < 2; ++kx) {
+        const AzTrTreeNode *np = tree->node(leaf_nx[kx]); 
+        target.quantize(np->data_indexes(), np->dxs_num); 
+      }
+    }
   }
   static void _updateTarget_LS(const AzRgfTree *tree, 
                                const int leaf_nx[2], 
@@ -213,6 +230,11 @@ protected:
 
   /*---  for search  ---*/
   virtual void searchBestSplit(AzTrTsplit *best_split); 
+  void limitSortedArrays(int first_tx, int last_tx, int keep_tx); 
+  inline int lastGrown(int tx) const {
+    if (tx >= ia_tree_grown.size()) return -1; 
+    return ia_tree_grown.get(tx); 
+  }
 
   /*----*/
   bool shouldExit(const AzTrTsplit *best_split) const; 
@@ -222,7 +244,7 @@ protected:
   int adjustTestInterval(int lnum_inc_test, int lnum_inc_opt); 
 
   virtual void show_tree_info() const; 
-  virtual void show_forExpoFamily(const AzDvect *v_dw) const; 
+  virtual void show_forExpoFamily(const AzFvect *v_dw) const; 
 
   /*! place holder for extension; called at the end of initialization  */
   virtual void end_of_initialization() {
@@ -249,14 +271,18 @@ protected:
   }
   virtual void time_show(); 
 
+  /*---  for memory accounting  ---*/
+  virtual void fitInMemory(int max_tree_num); 
+  virtual void sampleMem(int phase) const; 
+
   virtual void cold_start(const char *param, 
-              const AzSmat *m_x, 
+              AzSmat *m_x, /* destroyed */
               const AzDvect *v_y, 
               const AzSvFeatInfo *featInfo, 
               const AzDvect *v_fixed_dw, 
               const AzOut &out); 
   virtual void warm_start(const char *param,
-              const AzSmat *m_x,  
+              AzSmat *m_x, /* destroyed */
               const AzDvect *v_y, 
               const AzSvFeatInfo *featInfo, 
               const AzDvect *v_fixed_dw, 
@@ -22,11 +22,11 @@
 
 /*------------------------------------------------------*/
 /*------------------------------------------------------*/
-void AzSortedFeat_Dense::reset(const AzDvect *v_data_transpose, 
+void AzSortedFeat_Dense::reset(const AzFvect *v_data_transpose, 
                                    const AzIntArr *ia_dx) 
 {
   v_dx2v = v_data_transpose; 
-  const double *dx2value = v_dx2v->point(); 
+  const AZ_MTX_FLOAT *dx2value = v_dx2v->point(); 
 
   const int *dxs = ia_dx->point(); 
   AzIFarr ifa_dx_val; 
@@ -51,6 +51,29 @@ void AzSortedFeat_Dense::reset(const AzDvect *v_data_transpose,
   isOriginal = true; /* This is the original one.  Don't change. */
 }
 
+/*------------------------------------------------------*/
+int AzSortedFeat_Dense::write(AzFile *file)
+{
+  if (!isOriginal) {
+    throw new AzException("AzSortedFeat_Dense::write", "Not allowed"); 
+  }
+  return ia_index.write(file); 
+}
+
+/*------------------------------------------------------*/
+void AzSortedFeat_Dense::read(const AzFvect *v_data_transpose, 
+                              AzFile *file)
+{
+  v_dx2v = v_data_transpose; 
+  ia_index.read(file); 
+  if (ia_index.size() != v_dx2v->rowNum()) {
+    throw new AzException(AzInputError, "AzSortedFeat_Dense::read", "#data mismatch"); 
+  }
+  index = ia_index.point(&index_num); 
+  offset = 0; 
+  isOriginal = true; /* This is the original one.  Don't change. */
+}
+
 /*------------------------------------------------------*/
 void AzSortedFeat_Dense::filter(const AzSortedFeat_Dense *inp, 
                           const AzIntArr *ia_isYes, 
@@ -84,36 +107,61 @@ void AzSortedFeat_Dense::filter(const AzSortedFeat_Dense *inp,
 /*------------------------------------------------------*/
 /* place indexes so that yes's first and no's last and  */
 /* the order with yes's and no's does not change.       */
+/* Branch-free: every index is written to both sides    */
+/* and only the cursor on the matching side advances.   */
 /*------------------------------------------------------*/
 /* static */
 void AzSortedFeat_Dense::separate_indexes(int *index, 
                            int index_num, 
-                           const int *isYes, 
+                           const int *isYes, /* must cover all indexes */
                            int yes_num, 
-                           int max_dx)
+                           AzIntArr *ia_work)
 {
-  AzIntArr ia_no;  
-  ia_no.prepare(index_num-yes_num); 
-  int yes_ix = 0; 
+  if (ia_work->size() < index_num+1) {
+    ia_work->reset(index_num+1, 0); 
+  }
+  int *no = ia_work->point_u(); 
+  int yes_ix = 0, no_ix = 0; 
   int ix; 
   for (ix = 0; ix < index_num; ++ix) {
     int dx = index[ix]; 
-    if (dx <= max_dx && isYes[dx]) {
-      if (yes_ix != ix) {
-        index[yes_ix] = dx; 
-      }
-      ++yes_ix; 
-    }
-    else {
-      ia_no.put(dx); 
-    }
+    int is_yes = (isYes[dx] != 0); 
+    index[yes_ix] = dx; /* yes_ix <= ix; never overwrites unread ones */
+    no[no_ix] = dx; 
+    yes_ix += is_yes; 
+    no_ix += 1 - is_yes; 
   }
+  if (yes_ix != yes_num) {
+    throw new AzException("AzSortedFeat_Dense::separate_indexes", 
+                          "conflict in # of yes's"); 
+  }
+  if (no_ix > 0) {
+    memcpy(index+yes_ix, no, sizeof(int)*no_ix); 
+  }
+}
 
-  if (ia_no.size() > 0) {
-    memcpy(index+yes_ix, ia_no.point(), sizeof(int)*ia_no.size()); 
+/*------------------------------------------------------*/
+/* out-of-place version of separate_indexes.            */
+/*------------------------------------------------------*/
+/* static */
+void AzSortedFeat_Dense::separate_indexes_to(const int *index, 
+                           int index_num, 
+                           const int *isYes, /* must cover all indexes */
+                           int yes_num, 
+                           int *out_index)
+{
+  int yes_ix = 0, no_ix = yes_num; 
+  int ix; 
+  for (ix = 0; ix < index_num; ++ix) {
+    int dx = index[ix]; 
+    int is_yes = (isYes[dx] != 0); 
+    int pos = (is_yes) ? yes_ix : no_ix; 
+    out_index[pos] = dx; 
+    yes_ix += is_yes; 
+    no_ix += 1 - is_yes; 
   }
   if (yes_ix != yes_num) {
-    throw new AzException("AzSortedFeat_Dense::separate_indexes", 
+    throw new AzException("AzSortedFeat_Dense::separate_indexes_to", 
                           "conflict in # of yes's"); 
   }
 }
@@ -125,14 +173,14 @@ void AzSortedFeat_Dense::separate(
                           const AzIntArr *ia_isYes, 
                           int yes_num, 
                           AzSortedFeat_Dense *yes, 
-                          AzSortedFeat_Dense *no)
+                          AzSortedFeat_Dense *no, 
+                          AzIntArr *ia_work)
 {
   const char *eyec = "AzSortedFeat_Dense::separate"; 
 
   yes->v_dx2v = inp->v_dx2v; 
   no->v_dx2v = inp->v_dx2v; 
 
-  int max_dx = ia_isYes->size() - 1; 
   const int *isYes = ia_isYes->point(); 
 
   int base_index_num; 
@@ -140,13 +188,21 @@ void AzSortedFeat_Dense::separate(
 
   int *sub_index = base_index + inp->offset; 
 
-  if (inp->index != sub_index || 
-      inp->offset+inp->index_num > base_index_num) {
+  if (inp->offset+inp->index_num > base_index_num) {
+    throw new AzException(eyec, "index conflict"); 
+  }
+  if (inp->index == sub_index) {
+    separate_indexes(sub_index, inp->index_num, 
+                     isYes, yes_num, ia_work); 
+  }
+  else if (inp->isOriginal) {
+    /*---  the shared original is read only; write into the base  ---*/
+    separate_indexes_to(inp->index, inp->index_num, 
+                        isYes, yes_num, sub_index); 
+  }
+  else {
     throw new AzException(eyec, "index conflict"); 
   }
-
-  separate_indexes(sub_index, inp->index_num, 
-                   isYes, yes_num, max_dx); 
 
   yes->index = sub_index; 
   yes->index_num = yes_num; 
@@ -161,6 +217,21 @@ void AzSortedFeat_Dense::separate(
   }
 }
 
+/*------------------------------------------------------*/
+void AzSortedFeat_Dense::alloc_base(const AzSortedFeat_Dense *inp)
+{
+  if (!inp->isOriginal) {
+    throw new AzException("AzSortedFeat_Dense::alloc_base", 
+                          "Expected the original as input"); 
+  }
+  ia_index.reset_noinit(inp->index_num); /* separate() writes every slot */
+  v_dx2v = inp->v_dx2v; 
+  index = ia_index.point(&index_num); 
+  offset = 0; 
+
+  isOriginal = false; 
+}
+
 /*------------------------------------------------------*/
 void AzSortedFeat_Dense::copy_base(const AzSortedFeat_Dense *inp)
 {
@@ -180,6 +251,34 @@ void AzSortedFeat_Dense::copy_base(const AzSortedFeat_Dense *inp)
   isOriginal = false; /* This is a copy. */
 }
 
+/*--------------------------------------------------------*/
+/* Only Dense needs the base; Sparse gets an empty one.   */
+void AzSortedFeatArr::alloc_base(const AzSortedFeatArr *inp)
+{
+  const char *eyec = "AzSortedFeatArr::alloc_base"; 
+  beTight = inp->beTight; 
+  f_num = inp->featNum(); 
+  a_sparse.free(&arrs); 
+  a_dense.free(&arrd); 
+
+  ia_isActive.reset(); 
+  active_num = 0; 
+
+  if (beTight || inp->doingSparse()) {
+    return; 
+  }
+
+  a_dense.alloc(&arrd, f_num, eyec, "arrd"); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    if (inp->arrd == NULL || inp->arrd[fx] == NULL) {
+      throw new AzException(eyec, "No sorted dense features?!");
+    }
+    arrd[fx] = new AzSortedFeat_Dense(); 
+    arrd[fx]->alloc_base(inp->arrd[fx]); 
+  }
+}
+
 /* called when and only when data points are sampled */
 /*--------------------------------------------------------*/
 void AzSortedFeatArr::filter_base(const AzSortedFeatArr *inp, 
@@ -234,7 +333,7 @@ const
     return NULL;  /* end of data */
   }
 
-  const double *dx2value = v_dx2v->point(); 
+  const AZ_MTX_FLOAT *dx2value = v_dx2v->point(); 
 
   int dx = index[cursor]; 
   double curr_val = dx2value[dx]; 
@@ -264,12 +363,12 @@ const
 }
 
 /*------------------------------------------------------*/
-void AzSortedFeat_Dense::getIndexes(const int *inp_dxs, /* not used */
+int AzSortedFeat_Dense::getIndexes(const int * /* inp_dxs */, 
                               int inp_dxs_num, 
                               double border_val, 
                               /*---  output  ---*/
-                              AzIntArr *ia_le_dx, 
-                              AzIntArr *ia_gt_dx)
+                              int *out_dxs, 
+                              AzIntArr * /* ia_work */) 
 const
 {
   if (inp_dxs_num != index_num) {
@@ -277,15 +376,19 @@ const
                           "Conflict in # of data points"); 
   }
 
-  const double *dx2value = v_dx2v->point(); 
-  int ix; 
-  for (ix = 0; ix < index_num; ++ix) {
-    int dx = index[ix]; 
-    if (dx2value[dx] > border_val) break; 
+  /*---  values are in ascending order; find the first one > border  ---*/
+  const AZ_MTX_FLOAT *dx2value = v_dx2v->point(); 
+  int lo = 0, hi = index_num; 
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2; 
+    if (dx2value[index[mid]] > border_val) hi = mid; 
+    else                                   lo = mid + 1; 
   }
-  int le_size = ix; 
-  ia_le_dx->reset(index, le_size); 
-  ia_gt_dx->reset(index+le_size, index_num-le_size); 
+  int le_size = lo; 
+  if (out_dxs != index) {
+    memmove(out_dxs, index, sizeof(int)*index_num); 
+  }
+  return le_size; 
 }
 
 
@@ -350,6 +453,27 @@ void AzSortedFeat_Sparse::reset(const AzSvect *v_data_transpose,
   }
 }
 
+/*------------------------------------------------------*/
+int AzSortedFeat_Sparse::write(AzFile *file)
+{
+  int len = file->writeInt(data_num); 
+  len += file->writeBool(_shouldDoBackward); 
+  len += ia_zero.write(file); 
+  len += ia_index.write(file); 
+  len += v_value.write(file); 
+  return len; 
+}
+
+/*------------------------------------------------------*/
+void AzSortedFeat_Sparse::read(AzFile *file)
+{
+  data_num = file->readInt(); 
+  _shouldDoBackward = file->readBool(); 
+  ia_zero.read(file); 
+  ia_index.read(file); 
+  v_value.read(file); 
+}
+
 /*------------------------------------------------------*/
 void AzSortedFeat_Sparse::filter(const AzSortedFeat_Sparse *inp, 
                           const AzIntArr *ia_isYes, 
@@ -621,49 +745,58 @@ const
 }
 
 /*------------------------------------------------------*/
-void AzSortedFeat_Sparse::getIndexes(const int *inp_dxs, 
+int AzSortedFeat_Sparse::getIndexes(const int *inp_dxs, 
                               int inp_dxs_num, 
                               double border_val, 
                               /*---  output  ---*/
-                              AzIntArr *ia_le_dx, 
-                              AzIntArr *ia_gt_dx)
+                              int *out_dxs, 
+                              AzIntArr *ia_work)
 const
 {
-  ia_le_dx->reset(); 
-  ia_gt_dx->reset(); 
-  ia_le_dx->prepare(inp_dxs_num); 
-  ia_gt_dx->prepare(inp_dxs_num); 
-
+  /*---  this must be done before writing to out_dxs, which may be inp_dxs  ---*/
   AzIntArr ia_temp; 
   const AzIntArr *ia_zero_index = getIndexes_Zero(inp_dxs, inp_dxs_num, &ia_temp); 
+  int zero_num; 
+  const int *zero_index = ia_zero_index->point(&zero_num); 
+
+  if (ia_work->size() < inp_dxs_num+1) {
+    ia_work->reset(inp_dxs_num+1, 0); 
+  }
+  int *gt_dxs = ia_work->point_u(); 
 
   int num; 
   const int *index = ia_index.point(&num); 
   const double *value = v_value.point(); 
 
+  /*---  LE's go to out_dxs and GT's go to work without branching  ---*/
+  int le_num = 0, gt_num = 0; 
   int ix; 
   for (ix = 0; ix < num; ++ix) {
-    int dx = index[ix]; 
     if (value[ix] == 0) {
-      if (ia_zero_index->size() > 0) {
+      if (zero_num > 0) {
         if (0 <= border_val) {
-          ia_le_dx->concat(ia_zero_index);  
+          memcpy(out_dxs+le_num, zero_index, sizeof(int)*zero_num); 
+          le_num += zero_num; 
         }    
         else {
-          ia_gt_dx->concat(ia_zero_index); 
+          memcpy(gt_dxs+gt_num, zero_index, sizeof(int)*zero_num); 
+          gt_num += zero_num; 
         }
       }
+      continue; 
     }
-    else if (value[ix] <= border_val) {
-      ia_le_dx->put(dx); 
-    }
-    else {
-      ia_gt_dx->put(dx); 
-    }
+    int dx = index[ix]; 
+    int is_le = (value[ix] <= border_val); 
+    out_dxs[le_num] = dx; 
+    gt_dxs[gt_num] = dx; 
+    le_num += is_le; 
+    gt_num += 1 - is_le; 
   }
-  if (ia_le_dx->size() + ia_gt_dx->size() != inp_dxs_num) {
+  if (le_num + gt_num != inp_dxs_num) {
     throw new AzException("AzSortedFeat_Sparse::getIndexes", "num conflict"); 
   }
+  memcpy(out_dxs+le_num, gt_dxs, sizeof(int)*gt_num); 
+  return le_num; 
 }
 
 /*------------------------------------------------------*/
@@ -722,7 +855,7 @@ void AzSortedFeatArr::reset_sparse(const AzSmat *m_tran,
 }
 
 /*--------------------------------------------------------*/
-void AzSortedFeatArr::reset_dense(const AzDmat *m_tran_dense,   /* set */
+void AzSortedFeatArr::reset_dense(const AzFmat *m_tran_dense,   /* set */
                                   bool inp_beTight)
 {
   const char *eyec = "AzSortedFeatArr::reset (dense)"; 
@@ -746,6 +879,85 @@ void AzSortedFeatArr::reset_dense(const AzDmat *m_tran_dense,   /* set */
   }
 }
 
+/*--------------------------------------------------------*/
+AzInt64 AzSortedFeatArr::memSize() const
+{
+  AzInt64 size = (AzInt64)ia_isActive.size()*sizeof(int) + 
+                 (AzInt64)f_num*sizeof(void *); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    if (arrs != NULL && arrs[fx] != NULL) size += arrs[fx]->memSize(); 
+    if (arrd != NULL && arrd[fx] != NULL) size += arrd[fx]->memSize(); 
+  }
+  return size; 
+}
+
+/*--------------------------------------------------------*/
+int AzSortedFeatArr::write(AzFile *file)
+{
+  int len = file->writeInt(f_num); 
+  len += file->writeBool(doingSparse()); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    if (arrs != NULL) len += arrs[fx]->write(file); 
+    else              len += arrd[fx]->write(file); 
+  }
+  return len; 
+}
+
+/*--------------------------------------------------------*/
+void AzSortedFeatArr::read_sparse(const AzSmat *m_tran, 
+                                  AzFile *file, 
+                                  bool inp_beTight)
+{
+  const char *eyec = "AzSortedFeatArr::read_sparse"; 
+  beTight = inp_beTight; 
+  f_num = file->readInt(); 
+  bool isSparse = file->readBool(); 
+  if (f_num != m_tran->colNum() || !isSparse) {
+    throw new AzException(AzInputError, eyec, "conflict in #feat or data type"); 
+  }
+  ia_isActive.reset(); 
+  active_num = 0; 
+
+  a_sparse.free(&arrs); 
+  a_dense.free(&arrd); 
+  a_sparse.alloc(&arrs, f_num, eyec, "arrs"); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    arrs[fx] = new AzSortedFeat_Sparse(); 
+    arrs[fx]->read(file); 
+    if (arrs[fx]->dataNum() != m_tran->rowNum()) {
+      throw new AzException(AzInputError, eyec, "#data mismatch"); 
+    }
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzSortedFeatArr::read_dense(const AzFmat *m_tran_dense, 
+                                 AzFile *file, 
+                                 bool inp_beTight)
+{
+  const char *eyec = "AzSortedFeatArr::read_dense"; 
+  beTight = inp_beTight; 
+  f_num = file->readInt(); 
+  bool isSparse = file->readBool(); 
+  if (f_num != m_tran_dense->colNum() || isSparse) {
+    throw new AzException(AzInputError, eyec, "conflict in #feat or data type"); 
+  }
+  ia_isActive.reset(); 
+  active_num = 0; 
+
+  a_sparse.free(&arrs); 
+  a_dense.free(&arrd); 
+  a_dense.alloc(&arrd, f_num, eyec, "arrd"); 
+  int fx; 
+  for (fx = 0; fx < f_num; ++fx) {
+    arrd[fx] = new AzSortedFeat_Dense(); 
+    arrd[fx]->read(m_tran_dense->col(fx), file); 
+  }
+}
+
 /*--------------------------------------------------------*/
 void AzSortedFeatArr::copy_base(const AzSortedFeatArr *inp)
 {
@@ -840,6 +1052,7 @@ void AzSortedFeatArr::sub_initialize(const AzSortedFeatArr *inp,
 
 /*--------------------------------------------------------*/
 /* static */
+/* Features are independent of each other; process them in parallel.  */
 void AzSortedFeatArr::separate(AzSortedFeatArr *base, /* used only by Dense */
              const AzSortedFeatArr *inp, 
              const int *yes_dxs, int yes_dxs_num, 
@@ -862,43 +1075,90 @@ void AzSortedFeatArr::separate(AzSortedFeatArr *base, /* used only by Dense */
     return; 
   }
 
+  int f_num = inp->featNum(); 
   if (inp->doingSparse()) {
+    if (inp->arrs == NULL) {
+      throw new AzException(eyec, "No sparse sorted featuers given as input"); 
+    }
+    AzException *err = NULL; 
     int fx; 
-    for (fx = 0; fx < inp->featNum(); ++fx) {
-      if (inp->arrs == NULL || inp->arrs[fx] == NULL) {
-        throw new AzException(eyec, "No sparse sorted featuers given as input"); 
+#pragma omp parallel for schedule(dynamic)
+    for (fx = 0; fx < f_num; ++fx) {
+      try {
+        if (inp->arrs[fx] == NULL) {
+          throw new AzException(eyec, "No sparse sorted featuers given as input"); 
+        }
+        yes->arrs[fx] = new AzSortedFeat_Sparse(); 
+        no->arrs[fx] = new AzSortedFeat_Sparse(); 
+        AzSortedFeat_Sparse::separate(inp->arrs[fx], &ia_isActive, active_num,  
+                               yes->arrs[fx], no->arrs[fx]); 
+        if (yes->arrs[fx]->dataNum() != yes_dxs_num || 
+            no->arrs[fx]->dataNum() != no_dxs_num) {
+          throw new AzException(eyec, "conflict in pop (sparse)"); 
+        }
       }
-      yes->arrs[fx] = new AzSortedFeat_Sparse(); 
-      no->arrs[fx] = new AzSortedFeat_Sparse(); 
-      AzSortedFeat_Sparse::separate(inp->arrs[fx], &ia_isActive, active_num,  
-                             yes->arrs[fx], no->arrs[fx]); 
-      if (yes->arrs[fx]->dataNum() != yes_dxs_num || 
-          no->arrs[fx]->dataNum() != no_dxs_num) {
-        throw new AzException(eyec, "conflict in pop (sparse)"); 
+      catch (AzException *e) {
+#pragma omp critical (AzSortedFeatArr_separate)
+        {
+          if (err == NULL) err = e; 
+          else             delete e; 
+        }
       }
     }
+    if (err != NULL) throw err; 
   }
   else {
     if (base == NULL) {
       throw new AzException(eyec, "base is null.  something is wrong"); 
     }
-    int fx; 
-    for (fx = 0; fx < inp->featNum(); ++fx) {
-      if (base->arrd == NULL || base->arrd[fx] == NULL) {
-        throw new AzException(eyec, "No dense sorted featuers given as base"); 
-      }
-      if (inp->arrd == NULL || inp->arrd[fx] == NULL) {
-        throw new AzException(eyec, "No dense sorted featuers given as input"); 
-      }
-      yes->arrd[fx] = new AzSortedFeat_Dense(); 
-      no->arrd[fx] = new AzSortedFeat_Dense(); 
-      AzSortedFeat_Dense::separate(base->arrd[fx], 
-                               inp->arrd[fx], &ia_isActive, active_num,  
-                               yes->arrd[fx], no->arrd[fx]); 
-      if (yes->arrd[fx]->dataNum() != yes_dxs_num || 
-          no->arrd[fx]->dataNum() != no_dxs_num) {
-        throw new AzException(eyec, "conflict in pop (dense)"); 
+    if (base->arrd == NULL || inp->arrd == NULL) {
+      throw new AzException(eyec, "No dense sorted featuers given"); 
+    }
+
+    /*---  on/off covering no's too so that no range check is needed  ---*/
+    int max_dx = -1; 
+    int ix; 
+    for (ix = 0; ix < yes_dxs_num; ++ix) max_dx = MAX(max_dx, yes_dxs[ix]); 
+    for (ix = 0; ix < no_dxs_num; ++ix)  max_dx = MAX(max_dx, no_dxs[ix]); 
+    if (ia_isActive.size() < max_dx+1) {
+      ia_isActive.reset(max_dx+1, 0); 
+      int *isActive = ia_isActive.point_u(); 
+      for (ix = 0; ix < yes_dxs_num; ++ix) isActive[yes_dxs[ix]] = 1; 
+    }
+
+    AzException *err = NULL; 
+#pragma omp parallel
+    {
+      AzIntArr ia_work; /* per-thread scratch space */
+      int fx; 
+#pragma omp for schedule(dynamic)
+      for (fx = 0; fx < f_num; ++fx) {
+        try {
+          if (base->arrd[fx] == NULL) {
+            throw new AzException(eyec, "No dense sorted featuers given as base"); 
+          }
+          if (inp->arrd[fx] == NULL) {
+            throw new AzException(eyec, "No dense sorted featuers given as input"); 
+          }
+          yes->arrd[fx] = new AzSortedFeat_Dense(); 
+          no->arrd[fx] = new AzSortedFeat_Dense(); 
+          AzSortedFeat_Dense::separate(base->arrd[fx], 
+                                   inp->arrd[fx], &ia_isActive, active_num,  
+                                   yes->arrd[fx], no->arrd[fx], &ia_work); 
+          if (yes->arrd[fx]->dataNum() != yes_dxs_num || 
+              no->arrd[fx]->dataNum() != no_dxs_num) {
+            throw new AzException(eyec, "conflict in pop (dense)"); 
+          }
+        }
+        catch (AzException *e) {
+#pragma omp critical (AzSortedFeatArr_separate)
+          {
+            if (err == NULL) err = e; 
+            else             delete e; 
+          }
+        }
       }
     }
+    if (err != NULL) throw err; 
   }
 }
@@ -22,6 +22,7 @@
 #include "AzUtil.hpp"
 #include "AzSmat.hpp"
 #include "AzDmat.hpp"
+#include "AzFmat.hpp"
 
 
 class AzSortedFeat
@@ -31,11 +32,13 @@ public:
   virtual void rewind(AzCursor &cur) const = 0; 
   virtual const int *next(AzCursor &cur, double *out_val, int *out_num) const = 0; 
   virtual bool isForward() const = 0; 
-  virtual void getIndexes(const int *inp_dxs, int inp_dxs_num, 
+  /*!  Write LE's and then GT's to out_dxs (may be the same as inp_dxs).  */
+  /*!  Return #LE.  ia_work is scratch space.                             */
+  virtual int getIndexes(const int *inp_dxs, int inp_dxs_num, 
                               double border_val, 
                               /*---  output  ---*/
-                              AzIntArr *ia_le_dx, 
-                              AzIntArr *ia_gt_dx) const = 0; 
+                              int *out_dxs, 
+                              AzIntArr *ia_work) const = 0; 
 }; 
 
 class AzSortedFeat_Dense : public virtual AzSortedFeat
@@ -45,13 +48,13 @@ protected:
   const int *index; 
   int index_num; 
   int offset; 
-  const AzDvect *v_dx2v; 
+  const AzFvect *v_dx2v; 
   bool isOriginal; 
 
 public:
   AzSortedFeat_Dense() : v_dx2v(NULL), index(NULL), index_num(0), 
                          offset(-1), isOriginal(false) {}
-  AzSortedFeat_Dense(const AzDvect *v_data_transpose, 
+  AzSortedFeat_Dense(const AzFvect *v_data_transpose, 
                      const AzIntArr *ia_dx) 
                        : v_dx2v(NULL), index(NULL), index_num(0), 
                          offset(-1), isOriginal(false) {
@@ -70,10 +73,11 @@ public:
     copy_base(inp); 
   }
 
-  void reset(const AzDvect *v_data_transpose, const AzIntArr *ia_dx); 
+  void reset(const AzFvect *v_data_transpose, const AzIntArr *ia_dx); 
   void filter(const AzSortedFeat_Dense *inp,
               const AzIntArr *ia_isYes,
               int yes_num); 
+  void alloc_base(const AzSortedFeat_Dense *inp); 
 
   inline int dataNum() const {
     return index_num; 
@@ -103,18 +107,29 @@ public:
     return *this; 
   }
 
-  void getIndexes(const int *inp_dxs, int inp_dxs_num,  
+  int getIndexes(const int *inp_dxs, int inp_dxs_num,  
                               double border_val, 
                               /*---  output  ---*/
-                              AzIntArr *ia_le_dx, 
-                              AzIntArr *ia_gt_dx) const; 
+                              int *out_dxs, 
+                              AzIntArr *ia_work) const; 
 
+  /*---  only the original one can be written  ---*/
+  int write(AzFile *file); 
+  void read(const AzFvect *v_data_transpose, AzFile *file); 
+
+  /*---  bytes owned by this object; views into the base are free  ---*/
+  inline AzInt64 memSize() const {
+    return (AzInt64)ia_index.size()*sizeof(int); 
+  }
+
+  /*---  isYes must cover all the data indexes of inp  ---*/
   static void separate(AzSortedFeat_Dense *base, /* indexes will be swaped */
                        const AzSortedFeat_Dense *inp, 
                        const AzIntArr *isYes, 
                        int yes_num, 
                        AzSortedFeat_Dense *yes, 
-                       AzSortedFeat_Dense *no); 
+                       AzSortedFeat_Dense *no, 
+                       AzIntArr *ia_work); /* scratch space */
 
 protected:
   void copy_base(const AzSortedFeat_Dense *inp); 
@@ -123,7 +138,12 @@ protected:
                            int index_num, 
                            const int *isYes, 
                            int yes_num, 
-                           int max_dx); 
+                           AzIntArr *ia_work); 
+  static void separate_indexes_to(const int *index, 
+                           int index_num, 
+                           const int *isYes, 
+                           int yes_num, 
+                           int *out_index); 
 }; 
 
 
@@ -196,11 +216,19 @@ public:
     return *this; 
   }
 
-  void getIndexes(const int *inp_dxs, int inp_dxs_num, 
+  int getIndexes(const int *inp_dxs, int inp_dxs_num, 
                               double border_val, 
                               /*---  output  ---*/
-                              AzIntArr *ia_le_dx, 
-                              AzIntArr *ia_gt_dx) const; 
+                              int *out_dxs, 
+                              AzIntArr *ia_work) const; 
+
+  int write(AzFile *file); 
+  void read(AzFile *file); 
+
+  inline AzInt64 memSize() const {
+    return (AzInt64)(ia_zero.size()+ia_index.size())*sizeof(int) + 
+           (AzInt64)v_value.rowNum()*sizeof(double); 
+  }
 
   static void separate(const AzSortedFeat_Sparse *inp, 
                           const AzIntArr *isYes, 
@@ -255,8 +283,17 @@ public:
   }
   void reset_sparse(const AzSmat *m_tran, 
                     bool beTight=false); 
-  void reset_dense(const AzDmat *m_tran_dense, 
+  void reset_dense(const AzFmat *m_tran_dense, 
+                   bool inp_beTight=false); 
+
+  /*---  to save/restore the results of reset_sparse/reset_dense  ---*/
+  int write(AzFile *file); 
+  void read_sparse(const AzSmat *m_tran, 
+                   AzFile *file, 
                    bool inp_beTight=false); 
+  void read_dense(const AzFmat *m_tran_dense, 
+                  AzFile *file, 
+                  bool inp_beTight=false); 
 
   inline bool doingSparse() const {
     if (arrs != NULL) return true; 
@@ -281,6 +318,15 @@ public:
               int fx, 
               AzSortedFeatWork *out) const; 
 
+  AzInt64 memSize() const; 
+
+  /*---  turn on beTight right after reset_sparse/reset_dense  ---*/
+  inline void tighten() {
+    beTight = true; 
+    ia_isActive.reset(); 
+    active_num = 0; 
+  }
+
   void reset() {
     a_dense.free(&arrd); 
     a_sparse.free(&arrs); 
@@ -297,6 +343,8 @@ public:
 
   void copy_base(const AzSortedFeatArr *inp); 
   void filter_base(const AzSortedFeatArr *inp, const int *dxs, int dxs_num); 
+  /*---  space to separate the original (inp) into; contents are not copied  ---*/
+  void alloc_base(const AzSortedFeatArr *inp); 
 
 protected:
   static void sub_initialize(const AzSortedFeatArr *inp, 
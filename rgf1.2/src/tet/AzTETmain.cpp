@@ -90,11 +90,10 @@ const
 {
   AzSvDataS dataset; 
   dataset.read(x_fn, y_fn, fdic_fn); 
-  m_x->set(dataset.feat()); 
-  v_y->set(dataset.targets()); 
   if (featInfo != NULL) {
     featInfo->reset(dataset.featInfo()); 
   }
+  dataset.transfer_to(m_x, v_y); 
 }
 
 /*------------------------------------------------------------------*/
@@ -441,8 +440,7 @@ void AzTETmain::train_predict(const char *argv[], int argc,
   AzSmat m_test_x; 
   AzSvDataS dataset; 
   dataset.read_features_only(s_test_x_fn.c_str()); 
-  m_test_x.set(dataset.feat()); 
-  dataset.destroy(); 
+  dataset.transfer_to(&m_test_x); 
 
   print_config(s_tet_param, log_out); 
 
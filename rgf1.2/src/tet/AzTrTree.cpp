@@ -25,8 +25,7 @@ void AzTrTree::_release()
 {
   ia_root_dx.reset(); 
   a_node.free(&nodes); nodes_used = 0; 
-  a_split.free(&split); 
-  a_sorted_arr.free(&sorted_arr); 
+  _releaseSplitSorted(); 
 
   root_nx = AzNone; 
   curr_min_pop = curr_max_depth = -1; 
@@ -35,8 +34,45 @@ void AzTrTree::_release()
 /*--------------------------------------------------------*/
 void AzTrTree::_releaseWork()
 {
+  _releaseSplitSorted(); 
+  int nx; 
+  for (nx = 0; nx < nodes_used; ++nx) {
+    nodes[nx].sorted_base_nx = -1; 
+  }
+}
+
+/*--------------------------------------------------------*/
+void AzTrTree::_releaseSplitSorted()
+{
+  /*---  the pointer arrays don't own the objects; the pools do  ---*/
   a_split.free(&split); 
   a_sorted_arr.free(&sorted_arr);
+  pool_split.release(); 
+  pool_sorted_arr.release(); 
+  ia_split_work.reset(); 
+}
+
+/*--------------------------------------------------------*/
+AzInt64 AzTrTree::sortedArrSize() const
+{
+  if (sorted_arr == NULL) return 0; 
+  AzInt64 size = 0; 
+  int nx; 
+  for (nx = 0; nx < nodes_used; ++nx) {
+    if (sorted_arr[nx] != NULL) size += sorted_arr[nx]->memSize(); 
+  }
+  return size; 
+}
+
+/*--------------------------------------------------------*/
+void AzTrTree::releaseSortedArrays()
+{
+  if (sorted_arr == NULL) return; 
+  int nx; 
+  for (nx = 0; nx < nodes_used; ++nx) {
+    pool_sorted_arr.put(sorted_arr[nx]); sorted_arr[nx] = NULL; 
+    nodes[nx].sorted_base_nx = -1; 
+  }
 }
 
 /*--------------------------------------------------------*/
@@ -117,6 +153,11 @@ int AzTrTree::_newNode(int max_size)
     a_node.realloc(&nodes, node_max, eyec, "node"); 
     a_split.realloc(&split, node_max, eyec, "split"); 
     a_sorted_arr.realloc(&sorted_arr, node_max, eyec, "sorted_arr"); 
+    int nx; 
+    for (nx = node_no; nx < node_max; ++nx) {
+      split[nx] = NULL; 
+      sorted_arr[nx] = NULL; 
+    }
   } 
   else {
     /*---  initialize the new node  ---*/
@@ -193,39 +234,46 @@ void AzTrTree::_splitNode(const AzDataForTrTree *data,
   nodes[nx].fx = inp->fx; 
   nodes[nx].border_val = inp->border_val; 
 
-  AzIntArr ia_le, ia_gt; 
+  /*---  partition the data indexes of this node in place  ---*/
+  int *dxs = ia_root_dx.point_u() + nodes[nx].dxs_offset; 
+  if (nodes[nx].dxs != dxs || 
+      nodes[nx].dxs_offset + nodes[nx].dxs_num > ia_root_dx.size()) {
+    throw new AzException("AzTrTree::_splitNode", "data indexes are not in place"); 
+  }
+  AzIntArr *ia_work = &ia_split_work; 
+  int le_num = 0; 
   const AzSortedFeatArr *s_arr = sorted_arr[nx]; 
   if (s_arr == NULL) {
     if (nx == root_nx) {
       s_arr = data->sorted_array(); 
     }
     else {
-      throw new AzException("AzTrTree::_splitNode", "sorted_arr[nx]=null"); 
+      s_arr = sorted_array(nx, data); /* it was released to save memory */
     }
   }
   const AzSortedFeat *sorted = s_arr->sorted(inp->fx); 
   if (sorted == NULL) {
     AzSortedFeatWork tmp; 
-    const AzSortedFeat *my_sorted = sorted_arr[nx]->sorted(data->sorted_array(), 
+    const AzSortedFeat *my_sorted = s_arr->sorted(data->sorted_array(), 
                                     inp->fx, &tmp); 
-    my_sorted->getIndexes(nodes[nx].dxs, nodes[nx].dxs_num, inp->border_val, 
-                          &ia_le, &ia_gt); 
+    le_num = my_sorted->getIndexes(nodes[nx].dxs, nodes[nx].dxs_num, inp->border_val, 
+                          dxs, ia_work); 
   }
   else {
-    sorted->getIndexes(nodes[nx].dxs, nodes[nx].dxs_num, inp->border_val, 
-                       &ia_le, &ia_gt); 
+    le_num = sorted->getIndexes(nodes[nx].dxs, nodes[nx].dxs_num, inp->border_val, 
+                       dxs, ia_work); 
   }
 
   int le_offset = nodes[nx].dxs_offset; 
-  int gt_offset = le_offset + ia_le.size(); 
+  int gt_offset = le_offset + le_num; 
 
   int le_nx = _newNode(max_size); 
   nodes[nx].le_nx = le_nx; 
   AzTrTreeNode *np = &nodes[le_nx]; 
   np->depth = nodes[nx].depth + 1;
   np->dxs_offset = le_offset; 
-  np->dxs = set_data_indexes(le_offset, ia_le.point(), ia_le.size()); 
-  np->dxs_num = ia_le.size(); 
+  np->dxs = dxs; 
+  np->dxs_num = le_num; 
   np->parent_nx = nx; 
   np->weight = inp->bestP[0]; 
   if (curr_min_pop < 0 || np->dxs_num < curr_min_pop) curr_min_pop = np->dxs_num; 
@@ -236,8 +284,8 @@ void AzTrTree::_splitNode(const AzDataForTrTree *data,
   np = &nodes[gt_nx]; 
   np->depth = nodes[nx].depth + 1; 
   np->dxs_offset = gt_offset; 
-  np->dxs = set_data_indexes(gt_offset, ia_gt.point(), ia_gt.size()); 
-  np->dxs_num = ia_gt.size(); 
+  np->dxs = dxs + le_num; 
+  np->dxs_num = nodes[nx].dxs_num - le_num; 
   np->parent_nx = nx; 
   np->weight = inp->bestP[1]; 
   curr_min_pop = MIN(curr_min_pop, np->dxs_num); 
@@ -252,7 +300,7 @@ void AzTrTree::_splitNode(const AzDataForTrTree *data,
   dump_split(inp, nx, org_weight, out); 
 
   /*---  release split info for the node we just split  ---*/
-  delete split[nx]; split[nx] = NULL; 
+  pool_split.put(split[nx]); split[nx] = NULL; 
 }
 
 /*--------------------------------------------------------*/
@@ -409,10 +457,12 @@ const
   double *p = v_p->point_u(); 
   int num; 
   const int *dxs = ia_dx->point(&num); 
+  if (num <= 0) return; 
+  AzTreePacked packed(this); 
   int ix; 
   for (ix = 0; ix < num; ++ix) {
     int dx = dxs[ix]; 
-    p[dx] = apply(data, dx, NULL); 
+    p[dx] = packed.apply(AzDataForTrTree_Point(data, dx)); 
   }
 }
 
@@ -459,9 +509,11 @@ const
     throw new AzException("AzTrTree::updatePred", "dim mismatch"); 
   }
   double *p_val = v_pval->point_u(); 
+  if (data_num <= 0) return; 
+  AzTreePacked packed(this); 
   int dx; 
   for (dx = 0; dx < data_num; ++dx) {
-    p_val[dx] += apply(dfd, dx); 
+    p_val[dx] += packed.apply(AzDataForTrTree_Point(dfd, dx)); 
   }
 }
 
@@ -495,9 +547,8 @@ const int *AzTrTree::set_data_indexes(int offset,
   } 
 
   int *root_dxs = ia_root_dx.point_u(); 
-  int ix; 
-  for (ix = 0; ix < dxs_num; ++ix) {
-    root_dxs[ix+offset] = dxs[ix]; 
+  if (dxs_num > 0 && root_dxs + offset != dxs) {
+    memmove(root_dxs + offset, dxs, sizeof(int)*dxs_num); 
   }
   return root_dxs + offset; 
 }
@@ -600,8 +651,7 @@ void AzTrTree::quick_warmup(const AzTreeNodes *inp,
   root_nx = inp->root(); 
   nodes_used = inp->nodeNum(); 
   a_node.alloc(&nodes, nodes_used, eyec, "nodes"); 
-  a_split.free(&split); 
-  a_sorted_arr.free(&sorted_arr); 
+  _releaseSplitSorted(); 
   int nx; 
   for (nx = 0; nx < nodes_used; ++nx) {
     const AzTreeNode *inp_np = inp->node(nx); 
@@ -766,13 +816,11 @@ const AzSortedFeatArr *AzTrTree::sorted_array(int nx,
     throw new AzException(eyec, "no sorted_arr"); 
   }
 
-  if (sorted_arr[nx] != NULL) {
-    /*---  already exists  ---*/
-    return sorted_arr[nx]; 
-  }
-
   /*---  root  ---*/
-  if (nx == root_nx) {
+  if (nx == root_nx && 
+      (sorted_arr[nx] == NULL || nodes[nx].dxs_num == data->dataNum())) {
+    /*---  if not sampled, sorted_arr[root_nx] is only the space to separate  ---*/
+    /*---  the shared one into; the contents of the shared one are not there. ---*/
 #if 0
     if (nodes[nx].dxs_num != data->dataNum()) {
       /*---  Do not allow sampling  ---*/
@@ -782,8 +830,9 @@ const AzSortedFeatArr *AzTrTree::sorted_array(int nx,
 #else
     if (nodes[nx].dxs_num != data->dataNum()) {
       /*---  Allow sampling  ---*/
-      sorted_arr[nx] = new AzSortedFeatArr(data->sorted_array(), 
-                                           nodes[nx].dxs, nodes[nx].dxs_num); 
+      sorted_arr[nx] = pool_sorted_arr.get(); 
+      sorted_arr[nx]->filter_base(data->sorted_array(), 
+                                  nodes[nx].dxs, nodes[nx].dxs_num); 
       return sorted_arr[nx]; 
     }
     else {
@@ -792,36 +841,63 @@ const AzSortedFeatArr *AzTrTree::sorted_array(int nx,
 #endif 
   }
 
-  if (sorted_arr[root_nx] == NULL) {
-    /*---  we need this as the base for SortedFeat_Dense  ---*/
-    sorted_arr[root_nx] = new AzSortedFeatArr(data->sorted_array());     
+  if (sorted_arr[nx] != NULL) {
+    /*---  already exists  ---*/
+    return sorted_arr[nx]; 
   }
+
   int px = nodes[nx].parent_nx; 
   if (px < 0) {
     throw new AzException(eyec, "Not root, but no parent?!"); 
   }
 
+  if (sorted_arr[px] == NULL && px != root_nx) {
+    /*---  released to save memory; rebuild this one from the data  ---*/
+    /*---  it serves as the base for its descendants.              ---*/
+    sorted_arr[nx] = pool_sorted_arr.get(); 
+    sorted_arr[nx]->filter_base(data->sorted_array(), 
+                                nodes[nx].dxs, nodes[nx].dxs_num); 
+    nodes[nx].sorted_base_nx = nx; 
+    return sorted_arr[nx]; 
+  }
+
   const AzSortedFeatArr *inp = sorted_arr[px]; 
+  if (px == root_nx && inp == NULL) {
+    /*---  sampled: make the root's own; otherwise separate the shared one  ---*/
+    /*---  (read only) into this tree's base.                               ---*/
+    inp = sorted_array(px, data); 
+  }
   if (inp == NULL) {
     throw new AzException(eyec, "No input for separation"); 
   }
+  if (sorted_arr[root_nx] == NULL) {
+    /*---  we need this as the base for SortedFeat_Dense  ---*/
+    sorted_arr[root_nx] = pool_sorted_arr.get(); 
+    sorted_arr[root_nx]->alloc_base(data->sorted_array()); 
+  }
 
   /*---  make a new one and save it.  ---*/
-  AzSortedFeatArr *base = sorted_arr[root_nx]; 
+  int base_nx = nodes[px].sorted_base_nx; 
+  if (base_nx < 0) base_nx = root_nx; 
+  AzSortedFeatArr *base = sorted_arr[base_nx]; 
+  if (base == NULL) {
+    throw new AzException(eyec, "No base for separation"); 
+  }
 
   int le_nx = nodes[px].le_nx; 
   int gt_nx = nodes[px].gt_nx; 
   if (sorted_arr[le_nx] != NULL || sorted_arr[gt_nx] != NULL) {
     throw new AzException(eyec, "one child has sorted_arr and the other doesn't?!"); 
   }
-  sorted_arr[le_nx] = new AzSortedFeatArr(); 
-  sorted_arr[gt_nx] = new AzSortedFeatArr(); 
+  sorted_arr[le_nx] = pool_sorted_arr.get(); 
+  sorted_arr[gt_nx] = pool_sorted_arr.get(); 
   AzSortedFeatArr::separate(base, inp, 
                             nodes[le_nx].dxs, nodes[le_nx].dxs_num, 
                             nodes[gt_nx].dxs, nodes[gt_nx].dxs_num, 
                             sorted_arr[le_nx], sorted_arr[gt_nx]); 
-  if (px != root_nx) { /* can't delete the one at the root as it's the base */
-    delete sorted_arr[px]; sorted_arr[px] = NULL; 
+  nodes[le_nx].sorted_base_nx = nodes[gt_nx].sorted_base_nx = nodes[px].sorted_base_nx; 
+  if (px != root_nx && px != base_nx) { /* can't delete the base */
+    pool_sorted_arr.put(sorted_arr[px]); sorted_arr[px] = NULL; 
   }
 
   return sorted_arr[nx]; 
@@ -48,11 +48,17 @@ protected:
   AzIntArr ia_root_dx; /*!!! Do NOT add components after generating the root.  */
                        /*!!! All the nodes refer to the components by pointer. */
 
+  /*---  split and sorted_arr point to the objects in the pools.   ---*/
+  /*---  The pools are released in bulk when the tree is done.      ---*/
   AzTrTsplit **split;  
-  AzObjPtrArray<AzTrTsplit> a_split; 
+  AzBaseArray<AzTrTsplit *> a_split; 
+  mutable AzObjPool<AzTrTsplit> pool_split; 
 
   AzSortedFeatArr **sorted_arr; 
-  AzObjPtrArray<AzSortedFeatArr> a_sorted_arr; 
+  AzBaseArray<AzSortedFeatArr *> a_sorted_arr; 
+  mutable AzObjPool<AzSortedFeatArr> pool_sorted_arr; 
+
+  AzIntArr ia_split_work; /* scratch space for _splitNode */
 
   int curr_min_pop, curr_max_depth; 
   bool isBagging; 
@@ -74,6 +80,18 @@ public:
   /*---  for faster node search  ---*/
   virtual const AzSortedFeatArr *sorted_array(int nx, 
                              const AzDataForTrTree *data) const; 
+  /*---  bytes used by the sorted arrays; they can be released any time  ---*/
+  /*---  and are rebuilt from the data when needed.                       ---*/
+  AzInt64 sortedArrSize() const; 
+  void releaseSortedArrays(); 
+  /*---  bytes used by the split info  ---*/
+  inline AzInt64 splitSize() const {
+    return (AzInt64)pool_split.size()*sizeof(AzTrTsplit); 
+  }
+  /*---  bytes used by the nodes and the data indexes  ---*/
+  virtual AzInt64 memSize() const {
+    return (AzInt64)a_node.size()*sizeof(AzTrTreeNode) + ia_root_dx.memSize(); 
+  }
 
   /*---  information seeking ... ---*/
   inline int maxDepth() const {
@@ -146,11 +164,14 @@ public:
 
   /*---  to store data indexes to disk  ---*/
   virtual void forStoringDataIndexes(AzFile *file) {}
-  virtual int estimateSizeofDataIndexes(int data_num) {return -1;}
+  virtual void forCompressingDataIndexes() {}
+  virtual AzInt64 estimateSizeofDataIndexes(int data_num) {return -1;}
+  virtual bool isCompressingDataIndexes() const {return false;}
 protected:
   /*---  tools for derived classes; for building a tree  ---*/
   void _release(); 
   void _releaseWork(); 
+  void _releaseSplitSorted(); 
   int _newNode(int max_size); 
   void _genRoot(int max_size, const AzDataForTrTree *data, 
                 const AzIntArr *ia_dx=NULL); 
@@ -31,8 +31,8 @@ class AzTemp_forTrTreeEns {
 protected: 
   AzBytArr s_temp_prefix; 
   AzDataPool<AzFile> pool_file; 
-  int unit_size; 
-  static const int max_size = 2000000000; 
+  AzInt64 unit_size; 
+  static const AzInt64 max_size = 2000000000; /* start a new file beyond this */
 
 public:
   AzTemp_forTrTreeEns() : unit_size(-1) {}
@@ -58,10 +58,6 @@ public:
     if (unit_size <= 0) {
       return; 
     }
-    if (unit_size > max_size) {
-      throw new AzException(AzInputError, "AzTemp_forTrTreeEns::reset", 
-                            "Data size is too large."); 
-    }
     open_new_file(); 
   }
   AzFile *point_file() {
@@ -71,12 +67,19 @@ public:
       throw new AzException("AzTemp_forTrTreeEns", "The temporary file is not ready"); 
     }
     AzFile *file = pool_file.point_u(fx); 
-    int remain = max_size - file->size(); 
-    if (remain < unit_size) {
+    /*---  a unit larger than max_size gets a file of its own  ---*/
+    AzInt64 fsize = file->size(); 
+    if (fsize > 0 && max_size - fsize < unit_size) {
       file = open_new_file(); 
     }
     return file; 
   }
+  AzInt64 fileSize() {
+    AzInt64 size = 0; 
+    int fx; 
+    for (fx = 0; fx < pool_file.size(); ++fx) size += pool_file.point_u(fx)->size(); 
+    return size; 
+  }
 protected:
   AzFile *open_new_file() {
     int idx; 
@@ -105,12 +108,24 @@ protected:
   const char *dt_param; 
 
   AzTemp_forTrTreeEns<T> temp_files; 
+  bool doPackDxs; /* data indexes are kept compressed in memory */
+  bool doForcePackDxs; /* set by the caller before cold/warm start; not reset */
 
 public:
-  AzTrTreeEnsemble() : t(NULL), t_num(0), const_val(0), org_dim(-1), dt_param("") {}
+  AzTrTreeEnsemble() : t(NULL), t_num(0), const_val(0), org_dim(-1), dt_param(""), 
+                       doPackDxs(false), doForcePackDxs(false) {}
+
+  /*---  compress the data indexes in memory unless stored in temp files  ---*/
+  inline void forceCompressingDataIndexes(bool inp) {
+    doForcePackDxs = inp; 
+  }
+  inline AzInt64 tempFileSize() {
+    return temp_files.fileSize(); 
+  }
 
+  /*---  true if the data indexes of old trees must be restored before use  ---*/
   inline bool usingTempFile() const {
-    return temp_files.isActive(); 
+    return temp_files.isActive() || doPackDxs; 
   }
 
   inline void reset() {
@@ -120,6 +135,7 @@ public:
     s_param.reset(); 
     dt_param = ""; 
     temp_files.reset(); 
+    doPackDxs = false; 
   }
   inline void cold_start(
                     AzParam &param, 
@@ -137,6 +153,8 @@ public:
     org_dim = inp_org_dim; 
 
     temp_files.reset(&dummy_tree, data_num, s_temp_prefix); 
+    doPackDxs = !temp_files.isActive() && 
+                (doForcePackDxs || dummy_tree.isCompressingDataIndexes()); 
   }
 
   inline const char *param_c_str() const {
@@ -168,6 +186,7 @@ public:
     AzParam p(dt_param, false); 
     t[tx] = new T(p); 
     t[tx]->forStoringDataIndexes(temp_files.point_file()); 
+    if (doPackDxs) t[tx]->forCompressingDataIndexes(); 
     ++t_num; 
     if (out_tx != NULL) {
       *out_tx = tx; 
@@ -303,6 +322,8 @@ public:
     dummy_tree.printParam(out); 
 
     temp_files.reset(&dummy_tree, data->dataNum(), s_temp_prefix); 
+    doPackDxs = !temp_files.isActive() && 
+                (doForcePackDxs || dummy_tree.isCompressingDataIndexes()); 
 
     s_param.reset(param.c_str());   
     dt_param = s_param.c_str(); 
@@ -312,6 +333,7 @@ public:
     for (tx = 0; tx < t_num; ++tx) {
       t[tx] = new T(p); 
       t[tx]->forStoringDataIndexes(temp_files.point_file()); 
+      if (doPackDxs) t[tx]->forCompressingDataIndexes(); 
       if (search_t_num > 0 && tx < t_num-search_t_num) {
         t[tx]->quick_warmup(inp_ens->tree(tx), data, v_p, ia_tr_dx); 
       }
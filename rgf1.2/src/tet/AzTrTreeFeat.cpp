@@ -215,12 +215,14 @@ void AzTrTreeFeat::_updateMatrix(const AzDataForTrTree *data,
   /*---  generate features  ---*/
   AzDataArray<AzIntArr> aia_fx_dx(f_num-old_f_num); 
   int xx; 
+  AzIntArr ia_nx; 
   for (xx = 0; xx < tx_num; ++xx) {
     int tx = txs[xx]; 
+    AzTreePacked dtree(ens->tree(tx)); 
     int dx; 
     for (dx = 0; dx < data_num; ++dx) {
-      genFeats(ens->tree(tx), tx, data, dx, 
-               old_f_num, &aia_fx_dx); 
+      genFeats(&dtree, tx, data, dx, 
+               old_f_num, &aia_fx_dx, &ia_nx); 
     }
   }
 
@@ -231,20 +233,21 @@ void AzTrTreeFeat::_updateMatrix(const AzDataForTrTree *data,
 }
 
 /*------------------------------------------------------------------*/
-void AzTrTreeFeat::genFeats(const AzTrTree_ReadOnly *dtree, 
+void AzTrTreeFeat::genFeats(const AzTreePacked *dtree, 
                         int tx, 
                         const AzDataForTrTree *data, 
                         int dx, 
                         int fx_offs, 
                         /*---  output  ---*/
-                        AzDataArray<AzIntArr> *aia_fx_dx)
+                        AzDataArray<AzIntArr> *aia_fx_dx, 
+                        AzIntArr *ia_nx) /* work */
 const
 {
-  AzIntArr ia_nx; 
-  dtree->apply(data, dx, &ia_nx); 
+  ia_nx->reset_norelease(); 
+  dtree->apply(AzDataForTrTree_Point(data, dx), ia_nx); 
 
   int num; 
-  const int *nx = ia_nx.point(&num); 
+  const int *nx = ia_nx->point(&num); 
   int ix; 
   for (ix = 0; ix < num; ++ix) {
     int feat_no = (ip_featDef.point(tx))[nx[ix]]; 
@@ -28,6 +28,7 @@
 #include "AzDataForTrTree.hpp"
 #include "AzTrTreeEnsemble_ReadOnly.hpp"
 #include "AzTreeRule.hpp"
+#include "AzTreePacked.hpp"
 #include "AzParam.hpp"
 #include "AzHelp.hpp"
 
@@ -140,13 +141,14 @@ public:
 
 protected:
   void updateRulePools(); 
-  void genFeats(const AzTrTree_ReadOnly *dtree, 
+  void genFeats(const AzTreePacked *dtree, 
                 int tx, /* tree# of dtree */
                 const AzDataForTrTree *data, 
                 int dx, 
                 int fx_offs, 
                 /*---  output  ---*/
-                AzDataArray<AzIntArr> *aia_fx_dx) const; 
+                AzDataArray<AzIntArr> *aia_fx_dx, 
+                AzIntArr *ia_nx) const; /* work */
 
   int _update(const AzTrTree_ReadOnly *dtree, 
                       int tx, 
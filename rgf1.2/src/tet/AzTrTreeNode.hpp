@@ -25,7 +25,7 @@ class AzTrTree;
 
 /*---------------------------------------------*/
 /*! used only for training */
-class AzTrTreeNode : /* extends */ public virtual AzTreeNode {
+class AzTrTreeNode : /* extends */ public AzTreeNode {
 protected:
   const int *dxs; /* data indexes belonging to this node */
 
@@ -33,11 +33,15 @@ public:
   int dxs_offset;  /* position in the data indexes at the root */
   int dxs_num; 
   int depth; //!< node depth 
+  int sorted_base_nx; /* node whose sorted array holds the indexes for this */
+                      /* node's sorted array; -1: root                    */
 
-  AzTrTreeNode() : depth(-1), dxs(NULL), dxs_offset(-1), dxs_num(-1) {}
+  AzTrTreeNode() : depth(-1), dxs(NULL), dxs_offset(-1), dxs_num(-1), 
+                   sorted_base_nx(-1) {}
   void reset() {
     AzTreeNode::reset(); 
     depth = dxs_offset = dxs_num = -1; 
+    sorted_base_nx = -1; 
     dxs = NULL; 
   }
   void transfer_from(AzTrTreeNode *inp) {
@@ -46,6 +50,7 @@ public:
     dxs_offset = inp->dxs_offset; 
     dxs_num = inp->dxs_num; 
     depth = inp->depth; 
+    sorted_base_nx = inp->sorted_base_nx; 
   }
 
   inline const int *data_indexes() const {
@@ -21,24 +21,38 @@
 
 #include "AzUtil.hpp"
 #include "AzDmat.hpp"
+#include "AzFmat.hpp"
 
 //! Targets and data point weights for node split search.  
 /*--------------------------------------------------------*/
 class AzTrTtarget {
 protected:
-  AzDvect v_tar_dw, v_dw;
+  AzFvect v_tar_dw, v_dw; /* in AZ_MTX_FLOAT */
   AzDvect v_y; 
   AzDvect v_fixed_dw; /* data point weights assigned by users */
   double fixed_dw_sum; 
 
+  /*---  16-bit copies of tar_dw and dw for bandwidth-bound split search  ---*/
+  short *q_tar_dw, *q_dw; 
+  AzBaseArray<short> a_q_tar_dw, a_q_dw; 
+  double q_tar_step, q_dw_step; /* value represented by 1 */
+  double q_tol; /* quantization is off if negative */
+  bool isQ; 
+  unsigned int q_seed; 
+  static const int q_max = 32767; 
+
 public:
-  AzTrTtarget() : fixed_dw_sum(-1) {}
+  AzTrTtarget() : fixed_dw_sum(-1), q_tar_dw(NULL), q_dw(NULL), 
+                  q_tar_step(0), q_dw_step(0), q_tol(-1), isQ(false), q_seed(1) {}
   AzTrTtarget(const AzDvect *inp_v_y, 
-              const AzDvect *inp_v_fixed_dw=NULL) {
+              const AzDvect *inp_v_fixed_dw=NULL) 
+            : fixed_dw_sum(-1), q_tar_dw(NULL), q_dw(NULL), 
+              q_tar_step(0), q_dw_step(0), q_tol(-1), isQ(false), q_seed(1) {
     reset(inp_v_y, inp_v_fixed_dw); 
   }
   void reset(const AzDvect *inp_v_y, 
              const AzDvect *inp_v_fixed_dw=NULL) {
+    isQ = false; 
     v_dw.reform(inp_v_y->rowNum()); 
     v_dw.set(1); 
     v_tar_dw.set(inp_v_y); 
@@ -68,10 +82,13 @@ public:
     v_dw.scale(&v_fixed_dw); 
   }
 
-  AzTrTtarget(const AzTrTtarget *inp) {
+  AzTrTtarget(const AzTrTtarget *inp) 
+            : fixed_dw_sum(-1), q_tar_dw(NULL), q_dw(NULL), 
+              q_tar_step(0), q_dw_step(0), q_tol(-1), isQ(false), q_seed(1) {
     reset(inp); 
   }
 
+  /*!  The quantized copies are not copied; call quantize() if needed.  */
   void reset(const AzTrTtarget *inp) {
     if (inp != NULL) {
       v_tar_dw.set(&inp->v_tar_dw); 
@@ -79,22 +96,80 @@ public:
       v_y.set(&inp->v_y); 
       v_fixed_dw.set(&inp->v_fixed_dw); 
       fixed_dw_sum = inp->fixed_dw_sum; 
+      q_tol = inp->q_tol; 
+      q_seed = inp->q_seed; 
+      isQ = false; 
+    }
+  }
+
+  /*---  16-bit quantization for node search  ---*/
+  /*!  tol: largest quantization step allowed relative to the average */
+  /*!       magnitude.  If exceeded, node search uses the exact values. */
+  inline void set_quantize(double tol) {
+    q_tol = tol; 
+    isQ = false; 
+  }
+  inline bool isQuantized() const {
+    return isQ; 
+  }
+  inline const short *q_tarDw_arr() const {
+    return q_tar_dw; 
+  }
+  inline const short *q_dw_arr() const {
+    return q_dw; 
+  }
+  inline double q_tarDw_unit() const {
+    return q_tar_step; 
+  }
+  inline double q_dw_unit() const {
+    return q_dw_step; 
+  }
+
+  /*!  Refresh the quantized copies.  If dxs is given, only those data */
+  /*!  points are refreshed with the current scale, unless a value     */
+  /*!  falls out of range, in which case everything is redone.         */
+  void quantize(const int *dxs=NULL, int dxs_num=0) {
+    if (q_tol < 0) return; 
+    int num = v_tar_dw.rowNum(); 
+    if (dxs != NULL && isQ && 
+        _quantize(v_tar_dw.point(), dxs, dxs_num, q_tar_step, q_tar_dw) && 
+        _quantize(v_dw.point(), dxs, dxs_num, q_dw_step, q_dw)) {
+      return; 
     }
+
+    /*---  do everyone  ---*/
+    isQ = false; 
+    if (a_q_tar_dw.size() != num) {
+      a_q_tar_dw.free(&q_tar_dw); a_q_tar_dw.alloc(&q_tar_dw, num, "AzTrTtarget::quantize", "tar_dw"); 
+      a_q_dw.free(&q_dw);         a_q_dw.alloc(&q_dw, num, "AzTrTtarget::quantize", "dw"); 
+    }
+    if (num <= 0) return; 
+    q_tar_step = _unit(&v_tar_dw); 
+    q_dw_step = _unit(&v_dw); 
+    if (q_tar_step < 0 || q_dw_step < 0) {
+      return; /* too skewed for 16 bits; use the exact values */
+    }
+    _quantize(v_tar_dw.point(), NULL, num, q_tar_step, q_tar_dw); 
+    _quantize(v_dw.point(), NULL, num, q_dw_step, q_dw); 
+    isQ = true; 
   }
 
   void resetTargetDw(const AzDvect *v_tar, const AzDvect *inp_v_dw) {
     v_tar_dw.set(v_tar); 
     v_dw.set(inp_v_dw); 
-    v_tar_dw.scale(&v_dw); /* component-wise multiplication */
+    v_tar_dw.scale(inp_v_dw); /* component-wise multiplication */
   }
   void resetTarDw_residual(const AzDvect *v_p) { /* only for LS */
-    v_tar_dw.set(&v_y); 
-    v_tar_dw.add(v_p, -1); 
+    v_tar_dw.reform(v_y.rowNum()); 
+    const double *y = v_y.point(), *p = v_p->point(); 
+    AZ_MTX_FLOAT *r = v_tar_dw.point_u(); 
+    int dx; 
+    for (dx = 0; dx < v_y.rowNum(); ++dx) r[dx] = (AZ_MTX_FLOAT)(y[dx] - p[dx]); 
   }
-  inline const double *dw_arr() const {
+  inline const AZ_MTX_FLOAT *dw_arr() const {
     return v_dw.point(); 
   }
-  inline const double *tarDw_arr() const {
+  inline const AZ_MTX_FLOAT *tarDw_arr() const {
     return v_tar_dw.point(); 
   }
   inline const AzDvect *y() const {
@@ -103,16 +178,16 @@ public:
   inline int dataNum() const {
     return v_tar_dw.rowNum(); 
   }
-  inline AzDvect *tarDw_forUpdate() {
+  inline AzFvect *tarDw_forUpdate() {
     return &v_tar_dw; 
   }
-  inline const AzDvect *tarDw() const {
+  inline const AzFvect *tarDw() const {
     return &v_tar_dw; 
   }
-  inline AzDvect *dw_forUpdate() {
+  inline AzFvect *dw_forUpdate() {
     return &v_dw; 
   }
-  inline const AzDvect *dw() {
+  inline const AzFvect *dw() {
     return &v_dw; 
   }
   inline double getTarDwSum(const int *dxs, int dxs_num) const {
@@ -131,5 +206,37 @@ public:
   int dim() const {
     return v_tar_dw.rowNum(); 
   }
+
+protected:
+  /*---  returns the quantization step, or -1 if it violates the tolerance  ---*/
+  double _unit(const AzFvect *v) const {
+    double max_abs = v->maxAbs(); 
+    if (max_abs <= 0) return 1; /* all zero */
+    double unit = max_abs / (double)q_max; 
+    double avg_abs = v->absSum() / (double)v->rowNum(); 
+    if (unit > avg_abs * q_tol) {
+      return -1; 
+    }
+    return unit; 
+  }
+
+  /*---  stochastic rounding so that the expected value is unbiased  ---*/
+  /*---  returns false if a value is out of range                    ---*/
+  bool _quantize(const AZ_MTX_FLOAT *val, const int *dxs, int num, 
+                 double unit, 
+                 short *q) {
+    int ix; 
+    for (ix = 0; ix < num; ++ix) {
+      int dx = (dxs != NULL) ? dxs[ix] : ix; 
+      q_seed = q_seed * 1103515245 + 12345; 
+      double u = (double)(q_seed >> 8) / (double)(1 << 24); /* [0,1) */
+      double qv = floor(val[dx] / unit + u); 
+      if (qv > q_max || qv < -q_max) {
+        return false; 
+      }
+      q[dx] = (short)qv; 
+    }
+    return true; 
+  }
 }; 
 #endif 
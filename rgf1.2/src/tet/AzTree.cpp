@@ -50,6 +50,7 @@ void AzTree::copy_from(const AzTreeNodes *tree_nodes)
   for (nx = 0; nx < nodes_used; ++nx) {
     nodes[nx] = *tree_nodes->node(nx); 
   }               
+  packed.reset(this); 
 }
 
 /*--------------------------------------------------------*/
@@ -64,6 +65,7 @@ void AzTree::_read(AzFile *file)
   for (nx = 0; nx < nodes_used; ++nx) {
     nodes[nx].read(file); 
   }
+  packed.reset(this); 
 }
 
 /*--------------------------------------------------------*/
@@ -95,6 +97,7 @@ void AzTree::_release()
 {
   a_nodes.free(&nodes); nodes_used = 0; 
   root_nx = AzNone; 
+  packed.reset(); 
 }
 
 /*--------------------------------------------------------*/
@@ -215,6 +218,7 @@ void AzTree::clean_up()
     if (nodes[nx].isLeaf()) continue; 
     nodes[nx].weight = 0; /* zero-out non-leaf weights */
   }
+  packed.reset(this); 
 }
 
 /*--------------------------------------------------------*/
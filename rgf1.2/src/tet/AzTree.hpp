@@ -23,6 +23,8 @@
 #include "AzSmat.hpp"
 #include "AzSvFeatInfo.hpp"
 #include "AzTreeNodes.hpp"
+#include "AzTreePacked.hpp"
+#include "AzDmat.hpp"
 
 //!  Untrainalbe regression tree.  
 /*------------------------------------------*/
@@ -32,6 +34,7 @@ protected:
   int nodes_used; 
   AzTreeNode *nodes; 
   AzBaseArray<AzTreeNode> a_nodes; 
+  AzTreePacked packed; /* for apply; rebuilt whenever nodes change */
 
   inline void _checkNode(int nx, const char *eyec) const {
     if (nodes == NULL || nx < 0 || nx >= nodes_used) {
@@ -79,7 +82,12 @@ public:
   double apply(const AzReadOnlyVector *v_data, 
                AzIntArr *ia_node=NULL) const {
     checkNodes("apply"); 
-    return apply(v_data, this, ia_node); 
+    return packed.apply(AzTreePacked_Vect(v_data), ia_node, true); 
+  }
+  double apply(const AzDvect *v_data, 
+               AzIntArr *ia_node=NULL) const {
+    checkNodes("apply"); 
+    return packed.apply(AzTreePacked_Dense(v_data->point()), ia_node, true); 
   }
 
   void show(const AzSvFeatInfo *feat, const AzOut &out, 
@@ -0,0 +1,146 @@
+/* * * * *
+ *  AzTreePacked.hpp
+ *  Copyright (C) 2011, 2012 Rie Johnson
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * * * * */
+
+#ifndef _AZ_TREE_PACKED_HPP_
+#define _AZ_TREE_PACKED_HPP_
+
+#include "AzUtil.hpp"
+#include "AzReadOnlyMatrix.hpp"
+#include "AzTreeNodes.hpp"
+
+/*---  16 bytes; the two children of a node are next to each other  ---*/
+class AzTreeNodePacked {
+public:
+  double border_val; 
+  int fx; 
+  int le_px; /* x[fx] <= border_val; gt is le_px+1.  -1 if leaf */
+}; 
+AzDeclarePod(AzTreeNodePacked) 
+
+/*---  accessors of the feature values for AzTreePacked::apply  ---*/
+class AzTreePacked_Dense {
+protected:
+  const double *x; 
+public:
+  AzTreePacked_Dense(const double *inp) : x(inp) {}
+  inline bool isLE(int fx, double border_val) const {
+    return (x[fx] <= border_val); 
+  }
+}; 
+class AzTreePacked_Vect {
+protected:
+  const AzReadOnlyVector *v; 
+public:
+  AzTreePacked_Vect(const AzReadOnlyVector *inp) : v(inp) {}
+  inline bool isLE(int fx, double border_val) const {
+    return (v->get(fx) <= border_val); 
+  }
+}; 
+
+//! Read-only copy of a tree laid out for traversal.
+/*-------------------------------------------------------------*/
+/* Nodes are renumbered in breadth-first order so that the     */
+/* path from the root touches 16 bytes per node; weights and   */
+/* the original node numbers are kept in separate arrays.      */
+/*-------------------------------------------------------------*/
+class AzTreePacked {
+protected:
+  AzTreeNodePacked *pnodes; 
+  AzBaseArray<AzTreeNodePacked> a_pnodes; 
+  double *weight; 
+  AzBaseArray<double> a_weight; 
+  int *px2nx; 
+  AzBaseArray<int> a_px2nx; 
+  int node_num; 
+
+public:
+  AzTreePacked() : pnodes(NULL), weight(NULL), px2nx(NULL), node_num(0) {}
+  AzTreePacked(const AzTreeNodes *inp) 
+     : pnodes(NULL), weight(NULL), px2nx(NULL), node_num(0) {
+    reset(inp); 
+  }
+  ~AzTreePacked() {}
+  void reset() {
+    _release(); 
+  }
+  void reset(const AzTreeNodes *inp) {
+    const char *eyec = "AzTreePacked::reset"; 
+    _release(); 
+    int num = inp->nodeNum(); 
+    if (num <= 0 || inp->root() < 0) return; 
+    a_pnodes.alloc(&pnodes, num, eyec, "pnodes"); 
+    a_weight.alloc(&weight, num, eyec, "weight"); 
+    a_px2nx.alloc(&px2nx, num, eyec, "px2nx"); 
+    px2nx[0] = inp->root(); 
+    int filled = 1; 
+    int px; 
+    for (px = 0; px < filled; ++px) {
+      const AzTreeNode *np = inp->node(px2nx[px]); 
+      pnodes[px].border_val = np->border_val; 
+      pnodes[px].fx = np->fx; 
+      weight[px] = np->weight; 
+      if (np->isLeaf()) {
+        pnodes[px].le_px = -1; 
+        continue; 
+      }
+      if (filled+2 > num) {
+        throw new AzException(eyec, "corrupted tree"); 
+      }
+      pnodes[px].le_px = filled; 
+      px2nx[filled++] = np->le_nx; 
+      px2nx[filled++] = np->gt_nx; 
+    }
+    node_num = filled; 
+  }
+
+  inline int nodeNum() const {
+    return node_num; 
+  }
+
+  /*---  sum of the weights along the path; same order as the node walk  ---*/
+  template <class X>
+  inline double apply(const X &x,
+                      AzIntArr *ia_nx=NULL, /* appended: original node# on the path */
+                      bool doNonZeroOnly=false) /* skip nodes with zero weight */
+                      const {
+    if (node_num <= 0) {
+      throw new AzException("AzTreePacked::apply", "stuck"); 
+    }
+    double p_val = 0; 
+    int px = 0; 
+    for ( ; ; ) {
+      const AzTreeNodePacked *np = &pnodes[px]; 
+      p_val += weight[px]; 
+      if (ia_nx != NULL && (!doNonZeroOnly || weight[px] != 0)) {
+        ia_nx->put(px2nx[px]); 
+      }
+      if (np->le_px < 0) break; /* leaf */
+      px = (x.isLE(np->fx, np->border_val)) ? np->le_px : np->le_px+1; 
+    }
+    return p_val; 
+  }
+
+protected:
+  void _release() {
+    a_pnodes.free(&pnodes); 
+    a_weight.free(&weight); 
+    a_px2nx.free(&px2nx); 
+    node_num = 0; 
+  }
+}; 
+#endif